@@ -0,0 +1,51 @@
+/*
+ * Helpers shared by the phase1 benchmarks. Each benchmark records one
+ * latency sample per operation with benchRecord and prints a single
+ * machine-readable line with benchReport:
+ *
+ *   BENCH name=<name> ops=<n> elapsed_us=<t> ops_per_sec=<r>
+ *         p50_us=<a> p90_us=<b> p99_us=<c> max_us=<d>
+ *
+ * All times are measured with USLOSS_Clock().
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <usloss.h>
+
+#define BENCH_OPS 10000     /* operations timed by each benchmark */
+
+static int benchSamples[BENCH_OPS];
+static int benchCount = 0;
+
+/* Records the latency of one operation, in microseconds */
+static void benchRecord(int latency)
+{
+    if (benchCount < BENCH_OPS) {
+        benchSamples[benchCount++] = latency;
+    }
+}
+
+static int benchCompare(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+/* Prints the result line; elapsed is the wall time of all operations */
+static void benchReport(char *name, int elapsed)
+{
+    double opsPerSec = elapsed > 0 ? benchCount * 1000000.0 / elapsed : 0;
+
+    qsort(benchSamples, benchCount, sizeof(int), benchCompare);
+    printf("BENCH name=%s ops=%d elapsed_us=%d ops_per_sec=%.0f "
+           "p50_us=%d p90_us=%d p99_us=%d max_us=%d\n", name, benchCount,
+           elapsed, opsPerSec, benchSamples[benchCount * 50 / 100],
+           benchSamples[benchCount * 90 / 100],
+           benchSamples[benchCount * 99 / 100],
+           benchSamples[benchCount - 1]);
+}
+
+#endif /* _BENCH_H */
@@ -0,0 +1,56 @@
+/* blockMe/unblockProc round trip benchmark.
+ *
+ * Waiter blocks with blockMe. Waker, at a lower priority, unblocks it
+ * with unblockProc, so Waiter runs right away and blocks again. Each
+ * sample is the time from the unblockProc call until Waker runs again.
+ */
+
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+#define WAITER_BLOCK 20
+
+int Waiter(char *);
+int Waker(char *);
+
+int waiterPid;
+int done = 0;
+
+int start1(char *arg)
+{
+    int status;
+
+    waiterPid = fork1("Waiter", Waiter, NULL, USLOSS_MIN_STACK, 2);
+    fork1("Waker", Waker, NULL, USLOSS_MIN_STACK, 3);
+    join(&status);
+    join(&status);
+    quit(0);
+    return 0;
+}
+
+int Waiter(char *arg)
+{
+    while (!done) {
+        blockMe(WAITER_BLOCK);
+    }
+    quit(0);
+    return 0;
+}
+
+int Waker(char *arg)
+{
+    int start = USLOSS_Clock();
+
+    for (int i = 0; i < BENCH_OPS; i++) {
+        int before = USLOSS_Clock();
+        unblockProc(waiterPid);
+        benchRecord(USLOSS_Clock() - before);
+    }
+    benchReport("block_unblock", USLOSS_Clock() - start);
+
+    done = 1;
+    unblockProc(waiterPid);
+    quit(0);
+    return 0;
+}
@@ -0,0 +1,44 @@
+/* Fork and join throughput benchmark.
+ *
+ * Parent repeatedly forks a higher priority Child, which runs and quits
+ * right away, and then joins with it. Each sample is one fork+join.
+ */
+
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+int Parent(char *);
+int Child(char *);
+
+int start1(char *arg)
+{
+    int status;
+
+    fork1("Parent", Parent, NULL, USLOSS_MIN_STACK, 3);
+    join(&status);
+    quit(0);
+    return 0;
+}
+
+int Parent(char *arg)
+{
+    int status;
+    int start = USLOSS_Clock();
+
+    for (int i = 0; i < BENCH_OPS; i++) {
+        int before = USLOSS_Clock();
+        fork1("Child", Child, NULL, USLOSS_MIN_STACK, 2);
+        join(&status);
+        benchRecord(USLOSS_Clock() - before);
+    }
+    benchReport("fork_join", USLOSS_Clock() - start);
+    quit(0);
+    return 0;
+}
+
+int Child(char *arg)
+{
+    quit(0);
+    return 0;
+}
@@ -0,0 +1,60 @@
+/* Context switch ping-pong benchmark.
+ *
+ * Ping and Pong run at the same priority and take turns: each one
+ * unblocks the other and then blocks itself. Ping times each round
+ * trip, which is two context switches.
+ */
+
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+#define PINGPONG_BLOCK 20
+
+int Ping(char *);
+int Pong(char *);
+
+int pingPid;
+int pongPid;
+int done = 0;
+
+int start1(char *arg)
+{
+    int status;
+
+    pongPid = fork1("Pong", Pong, NULL, USLOSS_MIN_STACK, 3);
+    pingPid = fork1("Ping", Ping, NULL, USLOSS_MIN_STACK, 3);
+    join(&status);
+    join(&status);
+    quit(0);
+    return 0;
+}
+
+int Ping(char *arg)
+{
+    int start = USLOSS_Clock();
+
+    for (int i = 0; i < BENCH_OPS; i++) {
+        int before = USLOSS_Clock();
+        unblockProc(pongPid);
+        blockMe(PINGPONG_BLOCK);
+        benchRecord(USLOSS_Clock() - before);
+    }
+    benchReport("switch_pingpong", USLOSS_Clock() - start);
+
+    done = 1;
+    unblockProc(pongPid);
+    quit(0);
+    return 0;
+}
+
+int Pong(char *arg)
+{
+    blockMe(PINGPONG_BLOCK);
+    while (!done) {
+        unblockProc(pingPid);
+        blockMe(PINGPONG_BLOCK);
+    }
+    quit(0);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/* Zap latency benchmark.
+ *
+ * Zapper forks a lower priority Victim that waits until it is zapped
+ * and then quits. Each sample is the time zap takes to return.
+ */
+
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+int Zapper(char *);
+int Victim(char *);
+
+int start1(char *arg)
+{
+    int status;
+
+    fork1("Zapper", Zapper, NULL, USLOSS_MIN_STACK, 2);
+    join(&status);
+    quit(0);
+    return 0;
+}
+
+int Zapper(char *arg)
+{
+    int status;
+    int elapsed = 0;
+
+    for (int i = 0; i < BENCH_OPS; i++) {
+        int pid = fork1("Victim", Victim, NULL, USLOSS_MIN_STACK, 3);
+        int before = USLOSS_Clock();
+        zap(pid);
+        int latency = USLOSS_Clock() - before;
+        benchRecord(latency);
+        elapsed += latency;
+        join(&status);
+    }
+    benchReport("zap", elapsed);
+    quit(0);
+    return 0;
+}
+
+int Victim(char *arg)
+{
+    while (!isZapped())
+        ;
+    quit(0);
+    return 0;
+}
@@ -1,31 +1,77 @@
 #define DEBUG 1 //Degub constant
+#define TRACE 1 //Scheduler trace ring constant
 
 typedef struct procStruct procStruct;
 typedef struct procStruct * procPtr;
 
 struct procStruct {
-   procPtr         nextProcPtr;
-   procPtr         childProcPtr;
+   procPtr         nextProcPtr;       /* next process in priority's queue */
+   procPtr         prevProcPtr;       /* prev process in priority's queue */
+   procPtr         childProcPtr;      /* head of list of active children */
+   procPtr         lastChildPtr;      /* tail of list of active children */
    procPtr         nextSiblingPtr;
+   procPtr         prevSiblingPtr;
    procPtr         parentPtr;
-   procPtr         quitChildPtr;
+   procPtr         quitChildPtr;      /* head of list of quit children */
+   procPtr         lastQuitChildPtr;  /* tail of list of quit children */
    procPtr         nextQuitSibling;
-   procPtr         whoZapped;
+   procPtr         prevQuitSibling;
+   procPtr         whoZapped;         /* head of list of zappers */
+   procPtr         lastWhoZapped;     /* tail of list of zappers */
    procPtr         nextWhoZapped;
+   procPtr         prevWhoZapped;
+   procPtr         blockedOn;         /* process this one is waiting on */
+   procPtr         waiters;           /* head of list blocked in blockMeOn */
+   procPtr         nextWaiter;
+   procPtr         prevWaiter;
+   procPtr         nextRTProc;        /* next process in RTList */
    char            name[MAXNAME];     /* process's name */
    char            startArg[MAXARG];  /* args passed to process */
    USLOSS_Context  state;             /* current context for process */
-   short           pid;               /* process id */
-   int             priority;
+   int             pid;               /* process id, pid % MAXPROC is slot */
+   int             priority;          /* current (effective) priority */
+   int             ownPriority;       /* priority before inheritance */
+   int             basePriority;      /* priority given to fork1 */
    int (* startFunc) (char *);        /* function where process begins -- launch */
    char           *stack;
    unsigned int    stackSize;
+   int             stackPool;         /* stack size class, -1 if malloc'd */
    int             status;            /* READY, BLOCKED, QUIT, etc. */
    int             quitStatus;
-   int             startTime;
+   int             startTime;         /* start of the current time slice */
+   int             blockedSince;      /* time the process last blocked */
+   int             period;            /* real-time period, 0 if not real-time */
+   int             budget;            /* CPU time allowed per period */
+   int             budgetUsed;        /* CPU time used in the current period */
+   int             deadline;          /* end of the current period */
+   int             tickets;           /* share of the CPU in SCHED_STRIDE */
+   long long       stride;            /* STRIDE1 / tickets */
+   long long       pass;              /* virtual time, lowest runs next */
+   procStats       stats;             /* cumulative scheduler counters */
    int             zapped;
 };
 
+/* One FIFO of ready processes per priority level */
+typedef struct readyQueue readyQueue;
+
+struct readyQueue {
+   procPtr         head;
+   procPtr         tail;
+};
+
+/* A kernel task: a run-to-completion callback run by the task runner */
+typedef struct kernelTask kernelTask;
+
+struct kernelTask {
+   char            name[MAXNAME];
+   int (* func) (void *);             /* returns TASK_DONE to remove itself */
+   void           *arg;
+   int             status;            /* TASK_FREE, TASK_IDLE or TASK_QUEUED */
+   int             pending;           /* posts not yet run */
+   int             runs;
+   kernelTask     *next;              /* next task in TaskQueue */
+};
+
 struct psrBits {
     unsigned int curMode:1;
     unsigned int curIntEnable:1;
@@ -61,13 +107,76 @@ int getPsrPrevInteruptMode(int psrValue) {
 #define MAXPRIORITY 1
 #define SENTINELPID 1
 #define SENTINELPRIORITY (MINPRIORITY + 1)
+#define RTPRIORITY 0       /* real-time (EDF) class, ahead of priority 1 */
+#define NUMPRIORITIES (SENTINELPRIORITY + 1)
 #define TIME_SLICE 80000
 
+/* Free process slot bitmap, 64 slots per word, plus a summary bitmap with
+ * one bit per slot word that has a free slot */
+#define SLOTWORDS ((MAXPROC + 63) / 64)
+#define SUMMARYWORDS ((SLOTWORDS + 63) / 64)
+
+/* Stack pool: classes of 1, 2 and 4 times USLOSS_MIN_STACK */
+#define NUMSTACKCLASSES 3
+#define STACKSPERCLASS MAXPROC
+#define STACK_GUARD 1      /* 1 to put an inaccessible page below each stack */
+
+/* Pool of fixed-size stacks for one size class, reserved at startup */
+typedef struct stackClass stackClass;
+
+struct stackClass {
+   unsigned int    stackSize;         /* usable size of each stack */
+   char           *arena;             /* guard page + stack, per stack */
+   int             freeList[STACKSPERCLASS]; /* indexes of free stacks */
+   int             numFree;
+   int             highWater;         /* most stacks in use at once */
+};
+
+/* Scheduling modes, stored in schedMode */
+#define SCHED_PRIORITY 0   /* strict priority, round robin, one TIME_SLICE */
+#define SCHED_MLFQ 1       /* multi-level feedback queue */
+#define SCHED_STRIDE 2     /* proportional share, priorities 1..5 share one
+                              queue ordered by pass */
+
+#ifndef SCHED_MODE
+#define SCHED_MODE SCHED_PRIORITY
+#endif
+
+/* MLFQ quantum for each priority band 1..5, in microseconds */
+#define MLFQ_QUANTA {0, 20000, 40000, 80000, 120000, 160000, TIME_SLICE}
+#define MLFQ_BOOST_PERIOD 1000000 /* anti-starvation reset, in microseconds */
+
+/* Stride scheduling: tickets given for each priority 1..5 and the
+ * sentinel, and the constant strides are computed from */
+#define STRIDE_TICKETS {0, 160, 80, 40, 20, 10, 1}
+#define STRIDE1 (1 << 20)
+#define STRIDE_MAX_TICKETS 10000
+
+/* Priority inheritance: a process runs at the best priority of the
+ * processes blocked on it in join, zap or blockMeOn; 0 to disable */
+#ifndef PRIORITY_INHERITANCE
+#define PRIORITY_INHERITANCE 0
+#endif
+
+/* Most CPU a set of real-time processes may reserve, in permille */
+#define RT_MAX_UTILIZATION 900
+
+/* Kernel tasks share the stack of one runner process */
+#define TASK_RUNNER_PRIORITY MAXPRIORITY
+#define TASK_RUNNER_STACK USLOSS_MIN_STACK
+#define TASK_FREE 0
+#define TASK_IDLE 1        /* waiting for taskPost */
+#define TASK_QUEUED 2      /* posted, in TaskQueue */
+
 /* Process statuses */
 #define READY 1
 #define RUNNING 2
 #define QUIT 4
 #define EMPTY 5
+#define THROTTLED 6        /* real-time process out of budget for its period */
+#define PERIOD_BLOCKED 7   /* real-time process waiting for its next period */
 #define BLOCKED 8
 #define JOIN_BLOCKED 9
 #define ZAP_BLOCKED 10
+#define TASK_WAIT_BLOCK 100 /* task runner with nothing to run; above the
+                              statuses phases 2-4 and tests block with */
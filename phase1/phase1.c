@@ -13,23 +13,41 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "kernel.h"
+#include "trace.h"
 
 /* ------------------------- Prototypes ----------------------------------- */
 int sentinel (char *);
 extern int start1 (char *);
 void dispatcher(void);
 void launch();
+static int forkProc(char *name, int (*startFunc)(char *), char *arg,
+                    int stacksize, int priority, int period, int budget);
 static void checkDeadlock();
+extern int check_io();
 void addProcToReadyList(procPtr proc);
 void printReadyList();
 int getProcSlot();
+int findFreeSlot(int start);
+void setSlotFree(int slot, int isFree);
+procPtr getProc(int pid);
 void zeroProcStruct(int pid);
 void removeFromChildList(procPtr process);
 void removeFromQuitList(procPtr process);
+void addToChildList(procPtr parent, procPtr child);
+void addToZapperList(procPtr zapped, procPtr zapper);
 void clock_handler();
 int readtime();
-void disableInterrupts();
+int readSliceTime();
+void addBlockedTime(procPtr proc);
+void initStackPool();
+char *allocStack(procPtr proc, int stacksize);
+void freeStack(procPtr proc);
+void traceEvent(int type, int pid, int otherPid, int arg);
+void writeTrace();
+static void disableInterrupts();
 void addToQuitChildList(procPtr ptr);
 int getpid();
 void timeSlice();
@@ -37,7 +55,27 @@ int readCurStartTime();
 int zap(int pid);
 int isZapped();
 void removeFromReadyList(procPtr process);
+procPtr getHighestReadyProc();
+void moveToBackOfReadyList(procPtr process);
 void unblockZappers(procPtr ptr);
+int getTimeQuantum(procPtr proc);
+void setPriority(procPtr proc, int priority);
+void mlfqBoostAll();
+void updatePriority(procPtr proc, int depth);
+int inheritedPriority(procPtr proc);
+void updateChildPriorities(procPtr parent);
+void addToWaiterList(procPtr target, procPtr waiter);
+void removeFromWaiterList(procPtr waiter);
+int rtUtilization(int period, int budget);
+void removeFromRTList(procPtr proc);
+int releaseRTProcs();
+int readyQueueOf(procPtr proc);
+int runsBefore(procPtr proc, procPtr other);
+void chargeStride(procPtr proc, int usedTime);
+void readyBlockedProc(procPtr proc);
+int taskRunner(char *);
+void addToTaskQueue(kernelTask *task);
+void removeFromTaskQueue(kernelTask *task);
 /* -------------------------- Globals ------------------------------------- */
 
 // Patrick's debugging global variable...
@@ -46,8 +84,11 @@ int debugflag = 0;
 // the process table
 procStruct ProcTable[MAXPROC];
 
-// Process lists
-static procPtr ReadyList;
+// Process lists, one ready queue per priority
+static readyQueue ReadyList[NUMPRIORITIES];
+
+// bit p is set iff ReadyList[p] is non-empty
+static unsigned int ReadyBitmap;
 
 // current process ID
 procPtr Current;
@@ -55,6 +96,56 @@ procPtr Current;
 // the next pid to be assigned
 unsigned int nextPid = SENTINELPID;
 
+// process the next dispatch switches to directly, set by unblockHandoff
+static procPtr handoffTarget = NULL;
+
+// number of processes that are not EMPTY, and of real-time processes
+// THROTTLED or PERIOD_BLOCKED until a clock interrupt releases them
+static int liveProcs = 0;
+static int clockWaiting = 0;
+
+// bit i is set iff ProcTable[i] is EMPTY; FreeSummary tracks non-zero words
+static unsigned long long FreeSlots[SLOTWORDS];
+static unsigned long long FreeSummary[SUMMARYWORDS];
+
+// scheduling mode, SCHED_PRIORITY, SCHED_MLFQ or SCHED_STRIDE; set
+// before forking
+int schedMode = SCHED_MODE;
+
+// tickets for each priority, and the pass of the last process dispatched
+// from the stride queue, in SCHED_STRIDE
+static int strideTickets[NUMPRIORITIES] = STRIDE_TICKETS;
+static long long globalPass = 0;
+
+// nonzero if blocked processes lend their priority; set before forking
+int priorityInheritance = PRIORITY_INHERITANCE;
+
+// real-time processes, and the CPU they have reserved, in permille
+static procPtr RTList = NULL;
+static int rtReserved = 0;
+
+// MLFQ time quantum for each priority band
+static int mlfqQuanta[NUMPRIORITIES] = MLFQ_QUANTA;
+
+// time of the last MLFQ anti-starvation priority reset
+static int lastBoostTime = 0;
+
+// stack pool, one entry per size class
+static stackClass StackPool[NUMSTACKCLASSES];
+
+// number of stacks too large for the pool, which are malloc'd
+static int mallocStacks = 0;
+
+// scheduler trace ring and the number of records ever written to it
+static traceRecord TraceRing[TRACE_SIZE];
+static unsigned int traceCount = 0;
+
+// kernel tasks, the queue of posted tasks, and the process that runs
+// them, created by the first taskCreate
+static kernelTask TaskTable[MAXTASKS];
+static kernelTask *TaskQueue = NULL;
+static kernelTask *TaskQueueTail = NULL;
+static procPtr TaskRunner = NULL;
 
 /* -------------------------- Functions ----------------------------------- */
 /* ------------------------------------------------------------------------
@@ -72,6 +163,12 @@ unsigned int nextPid = SENTINELPID;
 void startup() {
     int result; // value returned by call to fork1()
 
+    // reserve the stack pool before any process is created
+    if (DEBUG && debugflag) {
+        USLOSS_Console("startup(): initializing the stack pool\n");
+    }
+    initStackPool();
+
     // initialize the process table
     if (DEBUG && debugflag) {
         USLOSS_Console("startup(): initializing process table, "
@@ -80,12 +177,17 @@ void startup() {
     for (int i = 0; i < MAXPROC; i++) {
         zeroProcStruct(i);
     }
+    liveProcs = 0;
 
     // Initialize the Ready list, etc.
     if (DEBUG && debugflag) {
         USLOSS_Console("startup(): initializing the Ready list\n");
     }
-    ReadyList = NULL;
+    for (int i = 0; i < NUMPRIORITIES; i++) {
+        ReadyList[i].head = NULL;
+        ReadyList[i].tail = NULL;
+    }
+    ReadyBitmap = 0;
 
     // Initialize the clock interrupt handler
     USLOSS_IntVec[USLOSS_CLOCK_INT] = clock_handler;
@@ -134,8 +236,13 @@ void startup() {
 *------------------------------------------------------------------------- */
 void finish()
 {
-    if (DEBUG && debugflag)
+    if (DEBUG && debugflag) {
         USLOSS_Console("in finish...\n");
+        dumpStackPool();
+    }
+    if (TRACE) {
+        writeTrace();
+    }
 } /* finish */
 
 /* ------------------------------------------------------------------------
@@ -157,6 +264,75 @@ void finish()
 *-------------------------------------------------------------------------- */
 int fork1(char *name, int (*startFunc)(char *), char *arg,
           int stacksize, int priority) {
+    return forkProc(name, startFunc, arg, stacksize, priority, 0, 0);
+} /* fork1 */
+
+/* ------------------------------------------------------------------------
+|  Name - fork1RT
+|
+|  Purpose - Creates a real-time process. Every period microseconds the
+|            process is given up to budget microseconds of CPU, and the
+|            real-time processes are run earliest deadline first, ahead of
+|            every priority class. The end of each period is the deadline.
+|            A process that uses up its budget is held until its next
+|            period. A process is only admitted if the real-time processes
+|            together reserve no more than RT_MAX_UTILIZATION of the CPU.
+|            Budgets and releases are enforced on clock interrupts, so
+|            periods should be a multiple of USLOSS_CLOCK_MS.
+|
+|  Parameters - the process procedure address, the size of the stack, the
+|               period and the budget, in microseconds.
+|
+|  Returns - The process id of the created child.
+|            -1 if no child could be created or the period or budget is
+|            invalid, -2 if stacksize is less than USLOSS_MIN_STACK, and
+|            -3 if the process would not fit in the real-time reservation.
+|
+|  Side Effects - as for fork1, and the process is added to RTList.
+*-------------------------------------------------------------------------- */
+int fork1RT(char *name, int (*startFunc)(char *), char *arg,
+            int stacksize, int period, int budget) {
+    if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
+        USLOSS_Console("fork1RT(): called while in user mode, by process %d."
+                       " Halting...\n", Current->pid);
+        USLOSS_Halt(1);
+    }
+    disableInterrupts();
+
+    if (period <= 0 || budget <= 0 || budget > period) {
+        if (DEBUG && debugflag) {
+            USLOSS_Console("fork1RT(): Process %s has an invalid period or "
+                           "budget!\n", name);
+        }
+        return -1;
+    }
+
+    /* Admission control */
+    if (rtReserved + rtUtilization(period, budget) > RT_MAX_UTILIZATION) {
+        if (DEBUG && debugflag) {
+            USLOSS_Console("fork1RT(): Process %s not admitted, %d permille "
+                           "already reserved\n", name, rtReserved);
+        }
+        return -3;
+    }
+    return forkProc(name, startFunc, arg, stacksize, RTPRIORITY, period,
+                    budget);
+} /* fork1RT */
+
+/* ------------------------------------------------------------------------
+|  Name - forkProc
+|
+|  Purpose - Does the work of fork1 and fork1RT.
+|
+|  Parameters - as for fork1, plus the real-time period and budget, which
+|               are 0 for a process that is not real-time.
+|
+|  Returns - as for fork1
+|
+|  Side Effects - ReadyList is changed, ProcTable is changed.
+*-------------------------------------------------------------------------- */
+static int forkProc(char *name, int (*startFunc)(char *), char *arg,
+                    int stacksize, int priority, int period, int budget) {
 
     int procSlot = -1; // The location in process table to store PCB
 
@@ -177,7 +353,7 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
     }
 
     /* Return -1 if priority is out of bounds */
-    if ((nextPid != SENTINELPID) && (priority > MINPRIORITY || 
+    if ((nextPid != SENTINELPID) && period == 0 && (priority > MINPRIORITY ||
                               priority < MAXPRIORITY)) {
         if (DEBUG && debugflag) {
             USLOSS_Console("fork1(): Process %s priority is out of "
@@ -204,6 +380,8 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
         }
         return -1;
     }
+    setSlotFree(procSlot, 0);
+    liveProcs++;
 
     /* Halt USLOSS if process name is too long */
     if ( strlen(name) >= (MAXNAME - 1) ) {
@@ -225,26 +403,29 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
     } else {
         strcpy(ProcTable[procSlot].startArg, arg);
     }
-    ProcTable[procSlot].stackSize = stacksize;
-    if ((ProcTable[procSlot].stack = malloc(stacksize)) == NULL) {
-        USLOSS_Console("fork1(): malloc fail!  Halting...\n");
-        USLOSS_Halt(1);
-    }
+    ProcTable[procSlot].stack = allocStack(&ProcTable[procSlot], stacksize);
     ProcTable[procSlot].priority = priority;
+    ProcTable[procSlot].ownPriority = priority;
+    ProcTable[procSlot].basePriority = priority;
+    ProcTable[procSlot].tickets = strideTickets[priority];
+    ProcTable[procSlot].stride = priority == RTPRIORITY ? 0 :
+                                 STRIDE1 / strideTickets[priority];
+    ProcTable[procSlot].pass = globalPass;
+
+    /* real-time processes start their first period now */
+    if (period > 0) {
+        ProcTable[procSlot].period = period;
+        ProcTable[procSlot].budget = budget;
+        ProcTable[procSlot].budgetUsed = 0;
+        ProcTable[procSlot].deadline = USLOSS_Clock() + period;
+        ProcTable[procSlot].nextRTProc = RTList;
+        RTList = &ProcTable[procSlot];
+        rtReserved += rtUtilization(period, budget);
+    }
 
     /* set parent, child, and sibling pointers */
     if (Current != NULL) {                    // Current is the parent process
-        if (Current->childProcPtr == NULL) {  // Current has no children
-            Current->childProcPtr = &ProcTable[procSlot];
-        } else {  // Current has children
-            procPtr child = Current->childProcPtr;
-
-            /* Insert child at end of Sib List */
-            while (child->nextSiblingPtr != NULL) {
-                child = child->nextSiblingPtr;
-            }
-            child->nextSiblingPtr = &ProcTable[procSlot]; 
-        }
+        addToChildList(Current, &ProcTable[procSlot]);
     } 
     ProcTable[procSlot].parentPtr = Current; // value could be NULL
     
@@ -256,6 +437,10 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
                        launch);
 
     p1_fork(ProcTable[procSlot].pid); // for future phase(s)
+    if (TRACE) {
+        traceEvent(TRACE_FORK, ProcTable[procSlot].pid,
+                   Current == NULL ? -1 : Current->pid, priority);
+    }
     
 
     /* Make process ready and add to ready list */
@@ -269,7 +454,7 @@ int fork1(char *name, int (*startFunc)(char *), char *arg,
         dispatcher();
     }
     return ProcTable[procSlot].pid;
-} /* fork1 */
+} /* forkProc */
 
 /*-------------------------------------------------------------------------
 |  Name - launch
@@ -349,7 +534,14 @@ int join(int *status) {
     /* No children has called quit */
     if (Current->quitChildPtr == NULL) { 
         Current->status = JOIN_BLOCKED;
+        Current->blockedSince = USLOSS_Clock();
+        if (TRACE) {
+            traceEvent(TRACE_BLOCK, Current->pid, -1, JOIN_BLOCKED);
+        }
         removeFromReadyList(Current);
+        if (priorityInheritance) {
+            updateChildPriorities(Current);
+        }
         if (DEBUG && debugflag) {
             USLOSS_Console("join(): %s is JOIN_BLOCKED.\n", Current->name);
             dumpProcesses();
@@ -410,6 +602,9 @@ void quit(int status) {
         USLOSS_Console("quit(): Quitting %s, status is %d.\n", 
                 Current->name, status);
     }
+    if (TRACE) {
+        traceEvent(TRACE_QUIT, Current->pid, -1, status);
+    }
 
     /* The process has an active child */
     if (Current->childProcPtr != NULL) {
@@ -422,6 +617,16 @@ void quit(int status) {
     Current->status = QUIT;
     removeFromReadyList(Current);
 
+    /* Give back a real-time process's CPU reservation */
+    if (Current->period > 0) {
+        removeFromRTList(Current);
+    }
+
+    /* Processes in blockMeOn stay blocked but no longer lend to this one */
+    while (Current->waiters != NULL) {
+        removeFromWaiterList(Current->waiters);
+    }
+
     /* For all processes that zapped this process, add to ready list and 
      * set status to READY. */
     if (isZapped()) {
@@ -444,11 +649,21 @@ void quit(int status) {
             zeroProcStruct(childPID);
         }
 
-        /* Clean up self and activate parent */
-        Current->parentPtr->status = READY;
+        /* Clean up self and activate parent if it is waiting in join */
         removeFromChildList(Current);
         addToQuitChildList(Current->parentPtr);
-        addProcToReadyList(Current->parentPtr);
+        if (Current->parentPtr->status == JOIN_BLOCKED) {
+            if (TRACE) {
+                traceEvent(TRACE_UNBLOCK, Current->parentPtr->pid,
+                           Current->pid, 0);
+            }
+            addBlockedTime(Current->parentPtr);
+            Current->parentPtr->status = READY;
+            addProcToReadyList(Current->parentPtr);
+            if (priorityInheritance) {
+                updateChildPriorities(Current->parentPtr);
+            }
+        }
         printReadyList();                        // only prints in debug mode
         currentPID = Current->pid;
 
@@ -457,8 +672,16 @@ void quit(int status) {
         addToQuitChildList(Current->parentPtr);
         removeFromChildList(Current);
         if(Current->parentPtr->status == JOIN_BLOCKED){
+           if (TRACE) {
+               traceEvent(TRACE_UNBLOCK, Current->parentPtr->pid,
+                          Current->pid, 0);
+           }
+           addBlockedTime(Current->parentPtr);
            addProcToReadyList(Current->parentPtr);
            Current->parentPtr->status = READY;
+           if (priorityInheritance) {
+               updateChildPriorities(Current->parentPtr);
+           }
         }
         printReadyList();                        // only prints in debug mode
 
@@ -519,8 +742,7 @@ int zap(int pid) {
     }
 
     /* Process to zap does not exist */
-    if (ProcTable[pid % MAXPROC].status == EMPTY || 
-            ProcTable[pid % MAXPROC].pid != pid) {
+    if (getProc(pid) == NULL) {
 
         USLOSS_Console("zap(): process being zapped does not exist."
                        "  Halting...\n");
@@ -545,17 +767,19 @@ int zap(int pid) {
                 Current->pid, pid);
     }
     Current->status = ZAP_BLOCKED;
+    Current->blockedSince = USLOSS_Clock();
+    if (TRACE) {
+        traceEvent(TRACE_ZAP, Current->pid, pid, 0);
+    }
     removeFromReadyList(Current);
     zapPtr = &ProcTable[pid % MAXPROC];
     zapPtr->zapped = 1;
 
     /* Add this process to the list of process who have zapped the process */
-    if (zapPtr->whoZapped == NULL) {
-        zapPtr->whoZapped = Current;
-    } else {
-        procPtr ptr = zapPtr->whoZapped;
-        zapPtr->whoZapped = Current;
-        zapPtr->whoZapped->nextWhoZapped = ptr;
+    addToZapperList(zapPtr, Current);
+    Current->blockedOn = zapPtr;
+    if (priorityInheritance) {
+        updatePriority(zapPtr, 0);
     }
     dispatcher();
     if (isZapped()) {
@@ -575,9 +799,12 @@ int isZapped() {
 |  Name - dispatcher
 |
 |  Purpose - dispatches ready processes.  The process with the highest
-|            priority (the first on the ready list) is scheduled to
-|            run.  The old process is swapped out and the new process
-|            swapped in.
+|            priority (the first on the highest non-empty ready queue) is
+|            scheduled to run and moved to the back of its queue.  The old
+|            process is swapped out and the new process swapped in. In
+|            SCHED_STRIDE the old process's pass is advanced first, and the
+|            process with the lowest pass is picked from the stride queue.
+|            After unblockHandoff the woken process is run instead.
 |
 |  Parameters - none
 |
@@ -592,29 +819,61 @@ void dispatcher(void) {
     
     /* Dispacher is called for the first time for starting process (start1) */
     if (Current == NULL) {
-        Current = ReadyList;
+        Current = getHighestReadyProc();
         if (DEBUG && debugflag) {
             USLOSS_Console("dispatcher(): dispatching %s.\n", Current->name);
         }
         Current->startTime = USLOSS_Clock();
+        Current->stats.dispatches++;
+        if (TRACE) {
+            traceEvent(TRACE_SWITCH, Current->pid, -1, 0);
+        }
 
         /* Enable Interrupts - returning to user code */
         USLOSS_PsrSet( USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT );
         USLOSS_ContextSwitch(NULL, &Current->state);
     } else {
         procPtr old = Current;
-        if (old->status == RUNNING) {
+        int now = USLOSS_Clock();
+        int preempted = old->status == RUNNING; // old is still runnable
+
+        old->stats.cpuTime += now - old->startTime;
+        if (old->period > 0) {
+            old->budgetUsed += now - old->startTime;
+        }
+        if (preempted) {
             old->status = READY;
         }
-        Current = ReadyList;
-        removeFromReadyList(Current);
+        if (schedMode == SCHED_STRIDE) {
+            chargeStride(old, now - old->startTime);
+        }
+        if (handoffTarget != NULL) {
+            Current = handoffTarget;
+            handoffTarget = NULL;
+        } else {
+            Current = getHighestReadyProc();
+            moveToBackOfReadyList(Current);
+        }
         Current->status = RUNNING;
-        addProcToReadyList(Current);
+        if (schedMode == SCHED_STRIDE && readyQueueOf(Current) == MAXPRIORITY) {
+            globalPass = Current->pass;
+        }
         if (DEBUG && debugflag) {
             USLOSS_Console("dispatcher(): dispatching %s.\n", 
                     Current->name);
         }
-        Current->startTime = USLOSS_Clock();
+        if (Current != old) {
+            if (TRACE) {
+                traceEvent(TRACE_SWITCH, Current->pid, old->pid, preempted);
+            }
+            if (preempted) {
+                old->stats.involuntarySwitches++;
+            } else {
+                old->stats.voluntarySwitches++;
+            }
+            Current->stats.dispatches++;
+        }
+        Current->startTime = now;
         p1_switch(old->pid, Current->pid);
 
         /* Enable Interrupts - returning to user code */
@@ -663,7 +922,10 @@ int sentinel (char *dummy) {
 |  Purpose - Checks to determine if a deadlock has occured. In phase1, a
 |            deadlock will occur if checkDeadlock is called and there
 |            are any processes, other then Sentinel, with a status other 
-|            then empty in the process table.
+|            then empty in the process table. Nothing is checked while
+|            check_io() reports a process waiting on a device or a
+|            real-time process is waiting for its next period. Runs in
+|            O(1) using the counts kept by fork1 and zeroProcStruct.
 |
 |  Parameters - none
 |
@@ -675,17 +937,15 @@ int sentinel (char *dummy) {
 |                 table.
 *------------------------------------------------------------------------- */
 static void checkDeadlock(){
-    int numProc = 0; // Number of processes in the process table
-
-    /* Check the status of every entry in the process table. Increment
-     * numProc if a process status in not EMPTY
-     */
-    for (int i = 0; i < MAXPROC; i++) {
-        if (ProcTable[i].status != EMPTY) {
-            numProc++;
-        }
+    /* Processes waiting on a device or, if real-time, for their next
+     * period will be woken by an interrupt */
+    if (check_io() == 1 || clockWaiting > 0) {
+        return;
     }
 
+    /* The task runner only waits for taskPost, so it does not count */
+    int numProc = liveProcs - (TaskRunner != NULL);
+
     /* A deadlock has occured */
     if(numProc > 1){
         USLOSS_Console("checkDeadlock(): numProc = %d. Only Sentinel"
@@ -700,7 +960,7 @@ static void checkDeadlock(){
 /*
  * Disables the interrupts.
  */
-void disableInterrupts()
+static void disableInterrupts()
 {
     // turn the interrupts OFF iff we are in kernel mode
     if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
@@ -716,45 +976,53 @@ void disableInterrupts()
 /*---------------------------- addProcToReadyList -----------------------
 |  Function addProcToReadyList
 |
-|  Purpose:  Adds a new process to the ready list. Process is added to 
-|            the list based on priority. Lower priorities are placed at
-|            the front of the list. A process is placed at the end of
-|            all processes with the same pritority.
+|  Purpose:  Adds a new process to the ready list. Process is appended to
+|            the queue for its priority, so a process is placed at the end
+|            of all processes with the same priority. Runs in O(1). The
+|            real-time queue is kept in deadline order instead, after any
+|            process with the same deadline, and in SCHED_STRIDE the
+|            stride queue is kept in pass order.
 |
 |  Parameters:  proc (IN) -- The process to be added to the ready list.
 |
 |  Returns:  None
 |
-|  Side Effects:  proc is added to the correct location in ready list.
+|  Side Effects:  proc is added to its ready queue (see readyQueueOf)
+|                 and the queue's bit is set in ReadyBitmap.
 *-------------------------------------------------------------------*/
 void addProcToReadyList(procPtr proc) {
+    int index = readyQueueOf(proc);
+    readyQueue *queue = &ReadyList[index];
+
     if (DEBUG && debugflag){
       USLOSS_Console("addProcToReadyList(): Adding process %s to ReadyList\n",
                      proc->name);
     }
-    /* Process being added is the Sentinel process */
-    if (ReadyList == NULL) {
-        ReadyList = proc;
-    } else {
-
-        /* all priorities in list are less than proc */
-        if(ReadyList->priority > proc->priority) {
-            procPtr temp = ReadyList;
-            ReadyList = proc;
-            proc->nextProcPtr = temp;
-
-        /* Add process before first greater priority */
-        } else {
-            procPtr next = ReadyList->nextProcPtr;
-            procPtr last = ReadyList;
-            while (next->priority <= proc->priority) {
-                last = next;
-                next = next->nextProcPtr;
-            }
-            last->nextProcPtr = proc;
-            proc->nextProcPtr = next;
+    proc->nextProcPtr = NULL;
+    proc->prevProcPtr = queue->tail;
+    if (index == MAXPRIORITY && schedMode == SCHED_STRIDE &&
+            proc->pass < globalPass) {
+        proc->pass = globalPass;     // no credit for time spent blocked
+    }
+    if (index == RTPRIORITY || schedMode == SCHED_STRIDE) {
+        while (proc->prevProcPtr != NULL &&
+                runsBefore(proc, proc->prevProcPtr)) {
+            proc->nextProcPtr = proc->prevProcPtr;
+            proc->prevProcPtr = proc->prevProcPtr->prevProcPtr;
         }
     }
+    if (proc->prevProcPtr == NULL) {
+        queue->head = proc;
+    } else {
+        proc->prevProcPtr->nextProcPtr = proc;
+    }
+    if (proc->nextProcPtr == NULL) {
+        queue->tail = proc;
+    } else {
+        proc->nextProcPtr->prevProcPtr = proc;
+    }
+    ReadyBitmap |= 1 << index;
+
     if (DEBUG && debugflag){
       USLOSS_Console("addProcToReadyList(): Process %s added to ReadyList\n",
                      proc->name);
@@ -762,6 +1030,45 @@ void addProcToReadyList(procPtr proc) {
     }
 } /* addProcToReadyList */
 
+/*---------------------------- getHighestReadyProc -----------------------
+|  Function getHighestReadyProc
+|
+|  Purpose:  Finds the process at the front of the highest priority
+|            non-empty ready queue using the lowest set bit of ReadyBitmap.
+|
+|  Parameters:  None
+|
+|  Returns:  The next process to run, or NULL if the ready list is empty.
+*-------------------------------------------------------------------*/
+procPtr getHighestReadyProc() {
+    if (ReadyBitmap == 0) {
+        return NULL;
+    }
+    return ReadyList[__builtin_ffs(ReadyBitmap) - 1].head;
+} /* getHighestReadyProc */
+
+/*---------------------------- moveToBackOfReadyList -----------------------
+|  Function moveToBackOfReadyList
+|
+|  Purpose:  Moves a process already on the ready list to the end of the
+|            queue for its priority (round robin within a priority). The
+|            real-time and stride queues stay in order.
+|
+|  Parameters:  process (IN) -- The process to move.
+|
+|  Returns:  None
+*-------------------------------------------------------------------*/
+void moveToBackOfReadyList(procPtr process) {
+    int index = readyQueueOf(process);
+
+    if (index == RTPRIORITY || schedMode == SCHED_STRIDE ||
+            ReadyList[index].tail == process) {
+        return;
+    }
+    removeFromReadyList(process);
+    addProcToReadyList(process);
+} /* moveToBackOfReadyList */
+
 /*---------------------------- printReadyList -----------------------
 |  Function printReadyList
 |
@@ -774,27 +1081,32 @@ void addProcToReadyList(procPtr proc) {
 |  Returns:  None
 *-------------------------------------------------------------------*/
 void printReadyList(){
-    char str[10000], str1[40];
-    
-    procPtr head = ReadyList;
-    
-    sprintf(str, "%s(%d:PID=%d)", head->name, head->priority, head->pid);
+    char str[10000], str1[80];
 
-    while (head->nextProcPtr != NULL) {
-        head = head->nextProcPtr;
-        sprintf(str1, " -> %s(%d:PID=%d)", head->name, head->priority, 
-                head->pid);
-        strcat(str, str1);
+    if (!(DEBUG && debugflag)) {
+        return;
     }
-    if (DEBUG && debugflag){
-      USLOSS_Console("printReadyList(): %s\n", str);
+
+    str[0] = '\0';
+    for (int i = RTPRIORITY; i < NUMPRIORITIES; i++) {
+        for (procPtr head = ReadyList[i].head; head != NULL;
+                head = head->nextProcPtr) {
+            sprintf(str1, "%s%s(%d:PID=%d)", str[0] == '\0' ? "" : " -> ",
+                    head->name, head->priority, head->pid);
+            strcat(str, str1);
+        }
     }
+    USLOSS_Console("printReadyList(): %s\n", str);
 } /* printReadyList */
 
 /*---------------------------- getProcSlot -----------------------
 |  Function getProcSlot
 |
-|  Purpose:  Finds an empty index in the process table (ProcTable). 
+|  Purpose:  Finds an empty index in the process table (ProcTable), the
+|            first one at or after nextPid % MAXPROC, wrapping around.
+|            nextPid is advanced so that nextPid % MAXPROC is the slot;
+|            pid / MAXPROC is then the slot's generation, and a stale
+|            pid never matches ProcTable[pid % MAXPROC].pid.
 |
 |  Parameters:  None
 |
@@ -802,24 +1114,108 @@ void printReadyList(){
 |            empty slot in the process table.
 *-------------------------------------------------------------------*/
 int getProcSlot() {
-    int hashedIndex = nextPid % MAXPROC;
-    int counter = 0;
-    while (ProcTable[hashedIndex].status != EMPTY) {
-        nextPid++;
-        hashedIndex = nextPid % MAXPROC;
-        if (counter >= MAXPROC) {
+    int start = nextPid % MAXPROC;
+    int slot = findFreeSlot(start);
+
+    if (slot == -1) {
+        slot = findFreeSlot(0);
+        if (slot == -1) {
             return -1;
         }
-        counter++;
     }
-    return hashedIndex;
+    nextPid += (slot - start + MAXPROC) % MAXPROC;
+    return slot;
 } /* getProcSlot */
 
+/*---------------------------- findFreeSlot -----------------------
+|  Function findFreeSlot
+|
+|  Purpose:  Finds the lowest EMPTY slot at or after start using the
+|            free slot bitmaps. Takes a constant number of bit scans for
+|            MAXPROC up to 4096.
+|
+|  Parameters:  start (IN) -- the first slot to consider
+|
+|  Returns:  the index of the slot, or -1 if none is free at or after start
+*-------------------------------------------------------------------*/
+int findFreeSlot(int start) {
+    int word = start / 64;
+    unsigned long long bits = FreeSlots[word] & (~0ULL << (start % 64));
+
+    if (bits != 0) {
+        return word * 64 + __builtin_ffsll(bits) - 1;
+    }
+
+    /* find the next slot word after this one with a free slot */
+    word++;
+    for (int i = word / 64; i < SUMMARYWORDS; i++) {
+        bits = FreeSummary[i];
+        if (i == word / 64) {
+            bits &= ~0ULL << (word % 64);
+        }
+        if (bits != 0) {
+            word = i * 64 + __builtin_ffsll(bits) - 1;
+            return word * 64 + __builtin_ffsll(FreeSlots[word]) - 1;
+        }
+    }
+    return -1;
+} /* findFreeSlot */
+
+/*---------------------------- setSlotFree -----------------------
+|  Function setSlotFree
+|
+|  Purpose:  Marks a process table slot as free or in use in the free
+|            slot bitmaps.
+|
+|  Parameters:  slot (IN) -- the slot index
+|               isFree (IN) -- 1 if the slot is now EMPTY, 0 otherwise
+|
+|  Returns:  None
+*-------------------------------------------------------------------*/
+void setSlotFree(int slot, int isFree) {
+    int word = slot / 64;
+
+    if (isFree) {
+        FreeSlots[word] |= 1ULL << (slot % 64);
+        FreeSummary[word / 64] |= 1ULL << (word % 64);
+    } else {
+        FreeSlots[word] &= ~(1ULL << (slot % 64));
+        if (FreeSlots[word] == 0) {
+            FreeSummary[word / 64] &= ~(1ULL << (word % 64));
+        }
+    }
+} /* setSlotFree */
+
+/*---------------------------- getProc -----------------------
+|  Function getProc
+|
+|  Purpose:  Looks up a process by pid in O(1).
+|
+|  Parameters:  pid (IN) -- the process id
+|
+|  Returns:  the process, or NULL if pid is not a live process (never
+|            created, already cleaned up, or a stale pid whose slot
+|            has been reused)
+*-------------------------------------------------------------------*/
+procPtr getProc(int pid) {
+    procPtr proc;
+
+    if (pid < 0) {
+        return NULL;
+    }
+    proc = &ProcTable[pid % MAXPROC];
+    if (proc->pid != pid || proc->status == EMPTY) {
+        return NULL;
+    }
+    return proc;
+} /* getProc */
+
 /*---------------------------- zeroProcStruct -----------------------
 |  Function zeroProcStruct
 |
 |  Purpose:  Initializes a ProcStruct. Members are set to 0, NULL, or -1.
-|            A process's quit status is set to a value of -666.
+|            A process's quit status is set to a value of -666. The
+|            process's stack, if it has one, is returned to the pool.
 |
 |  Parameters:
 |      pid (IN) --  The process ID to be zeroed
@@ -830,24 +1226,55 @@ int getProcSlot() {
 *-------------------------------------------------------------------*/
 void zeroProcStruct(int pid) {
     int index = pid % MAXPROC;
+    if (ProcTable[index].stack != NULL) {
+        freeStack(&ProcTable[index]);
+    }
+    if (ProcTable[index].status != EMPTY) {
+        liveProcs--;
+    }
     ProcTable[index].pid = -1;
     ProcTable[index].stackSize = -1;
     ProcTable[index].stack = NULL; 
+    ProcTable[index].stackPool = -1;
     ProcTable[index].priority = -1;
+    ProcTable[index].ownPriority = -1;
+    ProcTable[index].basePriority = -1;
     ProcTable[index].status = EMPTY;
+    setSlotFree(index, 1);
     ProcTable[index].childProcPtr = NULL;
+    ProcTable[index].lastChildPtr = NULL;
     ProcTable[index].nextSiblingPtr = NULL;
+    ProcTable[index].prevSiblingPtr = NULL;
     ProcTable[index].nextProcPtr = NULL;
+    ProcTable[index].prevProcPtr = NULL;
     ProcTable[index].quitChildPtr = NULL;
+    ProcTable[index].lastQuitChildPtr = NULL;
     ProcTable[index].nextQuitSibling = NULL;
+    ProcTable[index].prevQuitSibling = NULL;
     ProcTable[index].whoZapped = NULL;
+    ProcTable[index].lastWhoZapped = NULL;
     ProcTable[index].nextWhoZapped = NULL;
+    ProcTable[index].prevWhoZapped = NULL;
+    ProcTable[index].blockedOn = NULL;
+    ProcTable[index].waiters = NULL;
+    ProcTable[index].nextWaiter = NULL;
+    ProcTable[index].prevWaiter = NULL;
+    ProcTable[index].nextRTProc = NULL;
+    ProcTable[index].period = 0;
+    ProcTable[index].budget = 0;
+    ProcTable[index].budgetUsed = 0;
+    ProcTable[index].deadline = 0;
+    ProcTable[index].tickets = 0;
+    ProcTable[index].stride = 0;
+    ProcTable[index].pass = 0;
     ProcTable[index].name[0] = '\0';
     ProcTable[index].startArg[0] = '\0';
     ProcTable[index].startFunc = NULL;
     ProcTable[index].parentPtr = NULL;
     ProcTable[index].quitStatus = -666;
     ProcTable[index].startTime = -1;
+    ProcTable[index].blockedSince = -1;
+    memset(&ProcTable[index].stats, 0, sizeof(procStats));
     ProcTable[index].zapped = 0;
 } /* zeroProcStruct */
 
@@ -855,7 +1282,8 @@ void zeroProcStruct(int pid) {
 |  Function dumpProcesses
 |
 |  Purpose:  Loops through all procesess and prints all active
-|            processes (non empty processes).
+|            processes (non empty processes), with their total CPU
+|            time, dispatch count, and voluntary/involuntary switches.
 |
 |  Parameters:
 |            void
@@ -871,9 +1299,11 @@ void dumpProcesses(){
     char *join_blocked = "JOIN_BLOCKED";
     char *quit = "QUIT";
     char *zap_blocked = "ZAP_BLOCKED";
+    char *throttled = "THROTTLED";
+    char *period_blocked = "PERIOD_BLOCKED";
     USLOSS_Console("\n     PID       Name   Priority        Status     "
-            "Parent\n");
-    for(int i=0; i<50; i++){
+            "Parent    CPUtime  Dispatch  Vol/Invol\n");
+    for(int i=0; i<MAXPROC; i++){
         char buf[30];
         char *status = buf;
         char *parent;
@@ -891,6 +1321,10 @@ void dumpProcesses(){
                    break;               
                case ZAP_BLOCKED  : status = zap_blocked;
                    break;
+               case THROTTLED  : status = throttled;
+                   break;
+               case PERIOD_BLOCKED  : status = period_blocked;
+                   break;
                default : sprintf(status, "%d", ProcTable[i].status);
            }
            if(ProcTable[i].parentPtr != NULL){
@@ -898,18 +1332,48 @@ void dumpProcesses(){
            }else{
                parent = "NULL";
            }
-           USLOSS_Console("%8d %10s %10d %13s %10s\n", ProcTable[i].pid, 
-                          ProcTable[i].name, ProcTable[i].priority, 
-                          status, parent); 
+           int cpuTime = ProcTable[i].stats.cpuTime;
+           if (&ProcTable[i] == Current) {
+               cpuTime += readSliceTime();
+           }
+           USLOSS_Console("%8d %10s %10d %13s %10s %10d %9d %5d/%d\n",
+                          ProcTable[i].pid, ProcTable[i].name,
+                          ProcTable[i].priority, status, parent, cpuTime,
+                          ProcTable[i].stats.dispatches,
+                          ProcTable[i].stats.voluntarySwitches,
+                          ProcTable[i].stats.involuntarySwitches);
         }
     }
 }/* dumpProcesses */
 
+/*------------------------------------------------------------------
+|  Function addToChildList
+|
+|  Purpose:  Adds a process to the end of its parent's child list
+|
+|  Parameters:
+|            procPtr parent - the parent process
+|            procPtr child - the new child process
+|
+|  Returns:  void
+|
+|  Side Effects:  child is added to the back of parent's childList
+*-------------------------------------------------------------------*/
+void addToChildList(procPtr parent, procPtr child) {
+    child->nextSiblingPtr = NULL;
+    child->prevSiblingPtr = parent->lastChildPtr;
+    if (parent->lastChildPtr == NULL) {
+        parent->childProcPtr = child;
+    } else {
+        parent->lastChildPtr->nextSiblingPtr = child;
+    }
+    parent->lastChildPtr = child;
+}/* addToChildList */
+
 /*------------------------------------------------------------------
 |  Function removeFromChildList
 |
-|  Purpose:  Finds process in parent's childlist, removes process, reasigns
-|            all important processes
+|  Purpose:  Unlinks process from its parent's childlist in O(1)
 |
 |  Parameters:
 |            procPtr process, process to be deleted
@@ -919,20 +1383,23 @@ void dumpProcesses(){
 |  Side Effects:  Process is removed from parent's childList
 *-------------------------------------------------------------------*/
 void removeFromChildList(procPtr process) {
-    procPtr temp = process;
-    // process is at the head of the linked list
-    if (process == process->parentPtr->childProcPtr) {
-        process->parentPtr->childProcPtr = process->nextSiblingPtr;
-    } else { // process is in the middle or end of linked list
-        temp = process->parentPtr->childProcPtr;
-        while (temp->nextSiblingPtr != process) {
-            temp = temp->nextSiblingPtr;
-        }
-        temp->nextSiblingPtr = temp->nextSiblingPtr->nextSiblingPtr;
+    procPtr parent = process->parentPtr;
+
+    if (process->prevSiblingPtr == NULL) {
+        parent->childProcPtr = process->nextSiblingPtr;
+    } else {
+        process->prevSiblingPtr->nextSiblingPtr = process->nextSiblingPtr;
     }
+    if (process->nextSiblingPtr == NULL) {
+        parent->lastChildPtr = process->prevSiblingPtr;
+    } else {
+        process->nextSiblingPtr->prevSiblingPtr = process->prevSiblingPtr;
+    }
+    process->nextSiblingPtr = NULL;
+    process->prevSiblingPtr = NULL;
     if (DEBUG && debugflag) {
        USLOSS_Console("removeFromChildList(): Process %d removed.\n", 
-                      temp->pid);
+                      process->pid);
     }
 }/* removeFromChildList */
 
@@ -949,7 +1416,20 @@ void removeFromChildList(procPtr process) {
 |  Side Effects:  Process is removed from parent's quitList
 *-------------------------------------------------------------------*/
 void removeFromQuitList(procPtr process) {
-    process->parentPtr->quitChildPtr = process->nextQuitSibling;
+    procPtr parent = process->parentPtr;
+
+    if (process->prevQuitSibling == NULL) {
+        parent->quitChildPtr = process->nextQuitSibling;
+    } else {
+        process->prevQuitSibling->nextQuitSibling = process->nextQuitSibling;
+    }
+    if (process->nextQuitSibling == NULL) {
+        parent->lastQuitChildPtr = process->prevQuitSibling;
+    } else {
+        process->nextQuitSibling->prevQuitSibling = process->prevQuitSibling;
+    }
+    process->nextQuitSibling = NULL;
+    process->prevQuitSibling = NULL;
 
     if (DEBUG && debugflag) {
        USLOSS_Console("removeFromQuitList(): Process %d removed.\n", 
@@ -974,17 +1454,41 @@ void clock_handler() {
 |  Side Effects: the process is added back of the quit child list
 *-------------------------------------------------------------------*/
 void addToQuitChildList(procPtr ptr) {
-    if (ptr->quitChildPtr == NULL) {
+    Current->nextQuitSibling = NULL;
+    Current->prevQuitSibling = ptr->lastQuitChildPtr;
+    if (ptr->lastQuitChildPtr == NULL) {
         ptr->quitChildPtr = Current;
-        return;
-    }
-    procPtr child = ptr->quitChildPtr;
-    while (child->nextQuitSibling != NULL) {
-        child = child->nextQuitSibling;
+    } else {
+        ptr->lastQuitChildPtr->nextQuitSibling = Current;
     }
-    child->nextQuitSibling = Current;
+    ptr->lastQuitChildPtr = Current;
 }/* addToQuitChildList */
 
+/*------------------------------------------------------------------
+|  Function addToZapperList
+|
+|  Purpose:  Adds a process to the end of the list of processes that
+|            have zapped another process
+|
+|  Parameters:
+|            procPtr zapped - the process being zapped
+|            procPtr zapper - the process calling zap
+|
+|  Returns:  void
+|
+|  Side Effects: zapper is added to the back of zapped's whoZapped list
+*-------------------------------------------------------------------*/
+void addToZapperList(procPtr zapped, procPtr zapper) {
+    zapper->nextWhoZapped = NULL;
+    zapper->prevWhoZapped = zapped->lastWhoZapped;
+    if (zapped->lastWhoZapped == NULL) {
+        zapped->whoZapped = zapper;
+    } else {
+        zapped->lastWhoZapped->nextWhoZapped = zapper;
+    }
+    zapped->lastWhoZapped = zapper;
+}/* addToZapperList */
+
 /*
  * Returns the pid of the current process
  */
@@ -1000,20 +1504,83 @@ int readCurStartTime() {
 }
 
 /*
- * Calls dispatcher if a process has been time sliced
+ * Calls dispatcher if a process has used up its time quantum. In MLFQ mode
+ * the process is first demoted one priority band, and all priorities are
+ * periodically reset to keep demoted processes from starving. Real-time
+ * processes are released for their next period, run until they block or
+ * use up their budget, and preempt anything with a later deadline.
  */
 void timeSlice() {
-    if (readtime() >= TIME_SLICE) {
+    int released;
+
+    /* Idle with nothing waiting on the clock: a tick cannot make anything
+     * ready, so skip the bookkeeping and let the sentinel sleep */
+    if (Current->pid == SENTINELPID && clockWaiting == 0) {
+        return;
+    }
+    released = RTList != NULL && releaseRTProcs();
+
+    if (Current->period > 0) {
+        if (Current->budgetUsed + readSliceTime() >= Current->budget) {
+            Current->stats.overruns++;
+            Current->status = THROTTLED;
+            Current->blockedSince = USLOSS_Clock();
+            clockWaiting++;
+            if (TRACE) {
+                traceEvent(TRACE_BLOCK, Current->pid, -1, THROTTLED);
+            }
+            removeFromReadyList(Current);
+            dispatcher();
+        } else if (released) {
+            dispatcher();
+        }
+        return;
+    }
+    if (released) {
+        dispatcher();
+        return;
+    }
+    if (schedMode == SCHED_MLFQ &&
+            USLOSS_Clock() - lastBoostTime >= MLFQ_BOOST_PERIOD) {
+        /* everything starts a fresh quantum in the band it was forked in */
+        mlfqBoostAll();
+        dispatcher();
+        return;
+    }
+    if (readSliceTime() >= getTimeQuantum(Current)) {
+        if (schedMode == SCHED_MLFQ && Current->ownPriority < MINPRIORITY) {
+            Current->ownPriority++;
+            updatePriority(Current, 0);
+        }
         dispatcher();
     }
     return;
 }
 
+/*
+ * Returns the length of the time slice for a process under the current
+ * scheduling mode
+ */
+int getTimeQuantum(procPtr proc) {
+    if (schedMode == SCHED_MLFQ) {
+        return mlfqQuanta[proc->priority];
+    }
+    return TIME_SLICE;
+}
+
+/*
+ * Returns the total CPU time used by the current process, including the
+ * current time slice
+ */
+int readtime() {
+    return Current->stats.cpuTime + readSliceTime();
+}
+
 /*
  * Returns the difference between the current process's start time and
  * the USLOSS clock
  */
-int readtime() {
+int readSliceTime() {
     return USLOSS_Clock() - readCurStartTime();
 }
 
@@ -1048,7 +1615,24 @@ int blockMe(int newStatus){
       USLOSS_Halt(1);
     }
     Current->status = newStatus;
+    Current->blockedSince = USLOSS_Clock();
+    if (TRACE) {
+        traceEvent(TRACE_BLOCK, Current->pid, -1, newStatus);
+    }
     removeFromReadyList(Current);
+
+    /* MLFQ: a process that blocks before using its quantum moves up */
+    if (schedMode == SCHED_MLFQ &&
+            readSliceTime() < getTimeQuantum(Current) &&
+            Current->ownPriority > Current->basePriority) {
+        Current->ownPriority--;
+        updatePriority(Current, 0);
+    }
+
+    /* blocked in blockMeOn: lend our priority to the process we wait on */
+    if (priorityInheritance && Current->blockedOn != NULL) {
+        updatePriority(Current->blockedOn, 0);
+    }
     dispatcher();
     if (DEBUG && debugflag) {
         USLOSS_Console("blockMe(): Process %s is unblocked.\n", 
@@ -1061,41 +1645,443 @@ int blockMe(int newStatus){
 }/*blockMe */
 
 /*------------------------------------------------------------------
-|  Function unBlockProc
+|  Function blockMeOn
 |
-|  Purpose:  Unblocks a process blocked by blockMe
+|  Purpose:  Blocks a process like blockMe, recording the process it is
+|            waiting on. With priority inheritance on, that process runs
+|            at no worse than the blocked process's priority until the
+|            blocked process is unblocked.
 |
 |  Parameters:
-|            int pid - the pid of the process to unblock
+|            int newStatus - the status for the process to block on
+|            int pid - the process expected to unblock this one, or -1
 |
-|  Returns:  int - the return code
+|  Returns:  int - the return code, as for blockMe
 |
-|  Side Effects:  Process status is changed, added back to readyList
+|  Side Effects:  Process status is changed, removed from readyList,
+|                 the priority of pid may change
 *-------------------------------------------------------------------*/
-int unblockProc(int pid){
-    if (ProcTable[pid % MAXPROC].pid != pid) {
-        return -2;
+int blockMeOn(int newStatus, int pid) {
+    procPtr target = getProc(pid);
+
+    if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
+        USLOSS_Console("blockMeOn(): called while in user mode, by process "
+                       "%d. Halting...\n", Current->pid);
+        USLOSS_Halt(1);
     }
-    if (Current->pid == pid) {
-        return -2;
+    disableInterrupts();
+
+    if (target != NULL && target != Current && target->status != QUIT) {
+        addToWaiterList(target, Current);
+    }
+    return blockMe(newStatus);
+}/* blockMeOn */
+
+/*------------------------------------------------------------------
+|  Function waitPeriod
+|
+|  Purpose:  Ends the current job of a real-time process. The process
+|            blocks until its next period starts.
+|
+|  Parameters:  none
+|
+|  Returns:  int - 0 normally, -1 if the process was zapped while
+|            waiting, -2 if it is not a real-time process
+|
+|  Side Effects:  Process status is changed, removed from readyList
+*-------------------------------------------------------------------*/
+int waitPeriod() {
+    if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
+        USLOSS_Console("waitPeriod(): called while in user mode, by process "
+                       "%d. Halting...\n", Current->pid);
+        USLOSS_Halt(1);
     }
-    if (ProcTable[pid % MAXPROC].status < 11) {
+    disableInterrupts();
+
+    if (Current->period == 0) {
         return -2;
     }
+    Current->status = PERIOD_BLOCKED;
+    Current->blockedSince = USLOSS_Clock();
+    clockWaiting++;
+    if (TRACE) {
+        traceEvent(TRACE_BLOCK, Current->pid, -1, PERIOD_BLOCKED);
+    }
+    removeFromReadyList(Current);
+    dispatcher();
     if (isZapped()) {
         return -1;
     }
-    ProcTable[pid % MAXPROC].status = READY;
-    addProcToReadyList(&ProcTable[pid % MAXPROC]);
-    dispatcher();
     return 0;
-}/* unblockProc */
+}/* waitPeriod */
 
 /*------------------------------------------------------------------
-|  Function removeFromReadyList
+|  Function unBlockProc
 |
-|  Purpose:  Finds process in ReadyList, removes process, reasigns
-|            all important processes|
+|  Purpose:  Unblocks a process blocked by blockMe
+|
+|  Parameters:
+|            int pid - the pid of the process to unblock
+|
+|  Returns:  int - the return code
+|
+|  Side Effects:  Process status is changed, added back to readyList
+*-------------------------------------------------------------------*/
+int unblockProc(int pid){
+    procPtr proc = getProc(pid);
+
+    if (proc == NULL) {
+        return -2;
+    }
+    if (Current->pid == pid) {
+        return -2;
+    }
+    if (proc->status < 11) {
+        return -2;
+    }
+    if (isZapped()) {
+        return -1;
+    }
+    readyBlockedProc(proc);
+    dispatcher();
+    return 0;
+}/* unblockProc */
+
+/*------------------------------------------------------------------
+|  Function unblockMany
+|
+|  Purpose:  Unblocks a batch of processes blocked by blockMe. All of
+|            them are made ready before the dispatcher runs, once, so
+|            waking n processes costs one reschedule instead of n.
+|
+|  Parameters:
+|            int pids[] - the pids of the processes to unblock
+|            int n - the number of pids
+|
+|  Returns:  int - the number of processes unblocked, skipping any pid
+|            unblockProc would reject, or -1 if the caller was zapped
+|
+|  Side Effects:  Process statuses are changed, added back to readyList
+*-------------------------------------------------------------------*/
+int unblockMany(int pids[], int n) {
+    int unblocked = 0; // processes made ready
+
+    if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
+        USLOSS_Console("unblockMany(): called while in user mode, by process"
+                       " %d. Halting...\n", Current->pid);
+        USLOSS_Halt(1);
+    }
+    disableInterrupts();
+
+    if (isZapped()) {
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        procPtr proc = getProc(pids[i]);
+
+        if (proc == NULL || proc == Current || proc->status < 11) {
+            continue;
+        }
+        readyBlockedProc(proc);
+        unblocked++;
+    }
+    if (unblocked > 0) {
+        dispatcher();
+    }
+    return unblocked;
+}/* unblockMany */
+
+/*------------------------------------------------------------------
+|  Function unblockHandoff
+|
+|  Purpose:  Unblocks a process blocked by blockMe and, if nothing more
+|            urgent is ready, switches to it at once instead of leaving
+|            it at the back of its ready queue. Meant for request/reply
+|            rendezvous, where the caller is about to wait on the process
+|            it wakes. Otherwise the same as unblockProc.
+|
+|  Parameters:
+|            int pid - the pid of the process to unblock
+|
+|  Returns:  int - the return code, as for unblockProc
+|
+|  Side Effects:  Process status is changed, added back to readyList,
+|                 the caller is switched out
+*-------------------------------------------------------------------*/
+int unblockHandoff(int pid) {
+    procPtr proc = getProc(pid);
+
+    if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
+        USLOSS_Console("unblockHandoff(): called while in user mode, by "
+                       "process %d. Halting...\n", Current->pid);
+        USLOSS_Halt(1);
+    }
+    disableInterrupts();
+
+    if (proc == NULL || proc == Current || proc->status < 11) {
+        return -2;
+    }
+    if (isZapped()) {
+        return -1;
+    }
+    readyBlockedProc(proc);
+
+    /* hand off only if the woken process is in the best ready queue, and
+     * has the earliest deadline if it is real-time */
+    int best = __builtin_ffs(ReadyBitmap) - 1;
+    if (readyQueueOf(proc) == best &&
+            (best != RTPRIORITY || ReadyList[best].head == proc)) {
+        handoffTarget = proc;
+    }
+    dispatcher();
+    return 0;
+}/* unblockHandoff */
+
+/*------------------------------------------------------------------
+|  Function readyBlockedProc
+|
+|  Purpose:  Makes a process blocked by blockMe ready, without
+|            dispatching
+|
+|  Parameters:
+|            procPtr proc - the process to unblock
+|
+|  Returns:  void
+|
+|  Side Effects:  Process status is changed, added back to readyList
+*-------------------------------------------------------------------*/
+void readyBlockedProc(procPtr proc) {
+    if (TRACE) {
+        traceEvent(TRACE_UNBLOCK, proc->pid, Current->pid, 0);
+    }
+    addBlockedTime(proc);
+    proc->status = READY;
+    addProcToReadyList(proc);
+
+    /* stop lending priority to the process it was blocked on */
+    if (proc->blockedOn != NULL) {
+        procPtr target = proc->blockedOn;
+        removeFromWaiterList(proc);
+        updatePriority(target, 0);
+    }
+}/* readyBlockedProc */
+
+/*------------------------------------------------------------------
+|  Function taskCreate
+|
+|  Purpose:  Creates a kernel task. A task is a function that runs to
+|            completion each time it is posted with taskPost, with no
+|            stack or process of its own: every task runs on the stack of
+|            one task runner process, so a task must not block (blockMe,
+|            join, zap, MboxReceive and so on) or it holds up every other
+|            task. State kept between runs goes in arg. The runner is
+|            created by the first call, at TASK_RUNNER_PRIORITY.
+|
+|  Parameters:
+|            char *name - the task's name
+|            int (*func)(void *) - run once per post; returns TASK_DONE
+|                                  to remove the task, else 0
+|            void *arg - passed to func
+|
+|  Returns:  int - the task id, or -1 if func is NULL, the name is too
+|            long or the task table is full
+|
+|  Side Effects:  TaskTable is changed, the task runner may be created
+*-------------------------------------------------------------------*/
+int taskCreate(char *name, int (*func)(void *), void *arg) {
+    kernelTask *task = NULL;
+
+    if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
+        USLOSS_Console("taskCreate(): called while in user mode, by process"
+                       " %d. Halting...\n", Current->pid);
+        USLOSS_Halt(1);
+    }
+    disableInterrupts();
+
+    if (func == NULL || name == NULL || strlen(name) >= MAXNAME - 1) {
+        return -1;
+    }
+    for (int i = 0; i < MAXTASKS; i++) {
+        if (TaskTable[i].status == TASK_FREE) {
+            task = &TaskTable[i];
+            break;
+        }
+    }
+    if (task == NULL) {
+        if (DEBUG && debugflag) {
+            USLOSS_Console("taskCreate(): no free task for %s\n", name);
+        }
+        return -1;
+    }
+    strcpy(task->name, name);
+    task->func = func;
+    task->arg = arg;
+    task->status = TASK_IDLE;
+    task->pending = 0;
+    task->runs = 0;
+    task->next = NULL;
+
+    /* The runner belongs to no process, so whoever created it can still
+     * quit without waiting on it */
+    if (TaskRunner == NULL) {
+        int pid = fork1("taskRunner", taskRunner, NULL, TASK_RUNNER_STACK,
+                        TASK_RUNNER_PRIORITY);
+        if (pid < 0) {
+            task->status = TASK_FREE;
+            return -1;
+        }
+        disableInterrupts();
+        TaskRunner = getProc(pid);
+        removeFromChildList(TaskRunner);
+        TaskRunner->parentPtr = NULL;
+    }
+    return task - TaskTable;
+}/* taskCreate */
+
+/*------------------------------------------------------------------
+|  Function taskPost
+|
+|  Purpose:  Asks for a task to be run. A task posted n times runs n
+|            times, in the order posted with other tasks. May be called
+|            from an interrupt handler.
+|
+|  Parameters:
+|            int tid - the task id returned by taskCreate
+|
+|  Returns:  int - 0, or -1 if tid is not a task
+|
+|  Side Effects:  The task is added to TaskQueue, the task runner may
+|                 be unblocked and dispatched
+*-------------------------------------------------------------------*/
+int taskPost(int tid) {
+    kernelTask *task;
+
+    if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
+        USLOSS_Console("taskPost(): called while in user mode, by process"
+                       " %d. Halting...\n", Current->pid);
+        USLOSS_Halt(1);
+    }
+    disableInterrupts();
+
+    if (tid < 0 || tid >= MAXTASKS || TaskTable[tid].status == TASK_FREE) {
+        return -1;
+    }
+    task = &TaskTable[tid];
+    task->pending++;
+    if (task->status == TASK_QUEUED) {
+        return 0;
+    }
+    addToTaskQueue(task);
+
+    if (TaskRunner->status == TASK_WAIT_BLOCK && TaskRunner != Current) {
+        readyBlockedProc(TaskRunner);
+        dispatcher();
+    }
+    return 0;
+}/* taskPost */
+
+/*------------------------------------------------------------------
+|  Function taskRunner
+|
+|  Purpose:  Body of the task runner process. Takes the task at the head
+|            of TaskQueue, puts it back at the tail if it has more posts,
+|            and runs it with interrupts enabled. Blocks when the queue is
+|            empty.
+|
+|  Parameters:  unused
+|
+|  Returns:  never
+|
+|  Side Effects:  TaskQueue is changed, tasks may be freed
+*-------------------------------------------------------------------*/
+int taskRunner(char *dummy) {
+    while (1) {
+        disableInterrupts();
+        if (TaskQueue == NULL) {
+            blockMe(TASK_WAIT_BLOCK);
+            continue;
+        }
+        kernelTask *task = TaskQueue;
+        removeFromTaskQueue(task);
+        task->pending--;
+        task->runs++;
+        if (task->pending > 0) {
+            addToTaskQueue(task);
+        }
+        USLOSS_PsrSet(USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT);
+
+        int result = task->func(task->arg);
+
+        disableInterrupts();
+        if (result == TASK_DONE) {
+            if (task->status == TASK_QUEUED) {
+                removeFromTaskQueue(task);
+            }
+            task->status = TASK_FREE;
+        }
+    }
+    return 0;
+}/* taskRunner */
+
+/*------------------------------------------------------------------
+|  Function addToTaskQueue
+|
+|  Purpose:  Appends a task to TaskQueue
+|
+|  Parameters:
+|            kernelTask *task - the task to add
+|
+|  Returns:  void
+|
+|  Side Effects:  TaskQueue is changed, the task is TASK_QUEUED
+*-------------------------------------------------------------------*/
+void addToTaskQueue(kernelTask *task) {
+    task->status = TASK_QUEUED;
+    task->next = NULL;
+    if (TaskQueue == NULL) {
+        TaskQueue = task;
+    } else {
+        TaskQueueTail->next = task;
+    }
+    TaskQueueTail = task;
+}/* addToTaskQueue */
+
+/*------------------------------------------------------------------
+|  Function removeFromTaskQueue
+|
+|  Purpose:  Unlinks a task from TaskQueue. O(1) for the head, which is
+|            the usual case.
+|
+|  Parameters:
+|            kernelTask *task - the task to remove
+|
+|  Returns:  void
+|
+|  Side Effects:  TaskQueue is changed, the task is TASK_IDLE
+*-------------------------------------------------------------------*/
+void removeFromTaskQueue(kernelTask *task) {
+    kernelTask *prev = NULL;
+
+    for (kernelTask *t = TaskQueue; t != task; t = t->next) {
+        prev = t;
+    }
+    if (prev == NULL) {
+        TaskQueue = task->next;
+    } else {
+        prev->next = task->next;
+    }
+    if (TaskQueueTail == task) {
+        TaskQueueTail = prev;
+    }
+    task->next = NULL;
+    task->status = TASK_IDLE;
+}/* removeFromTaskQueue */
+
+/*------------------------------------------------------------------
+|  Function removeFromReadyList
+|
+|  Purpose:  Unlinks process from its ready queue in O(1) and clears the
+|            queue's bit if the queue empties.
 |  
 |  Parameters:
 |            procPtr process, process to be deleted
@@ -1105,14 +2091,23 @@ int unblockProc(int pid){
 |  Side Effects:  Process is removed from ReadyList
 *-------------------------------------------------------------------*/
 void removeFromReadyList(procPtr process) {
-    if(process == ReadyList){
-        ReadyList = ReadyList->nextProcPtr;
-    }else{
-        procPtr proc = ReadyList;
-        while(proc->nextProcPtr != process){
-            proc = proc->nextProcPtr;
-        }
-        proc->nextProcPtr = proc->nextProcPtr->nextProcPtr;
+    int index = readyQueueOf(process);
+    readyQueue *queue = &ReadyList[index];
+
+    if (process->prevProcPtr == NULL) {
+        queue->head = process->nextProcPtr;
+    } else {
+        process->prevProcPtr->nextProcPtr = process->nextProcPtr;
+    }
+    if (process->nextProcPtr == NULL) {
+        queue->tail = process->prevProcPtr;
+    } else {
+        process->nextProcPtr->prevProcPtr = process->prevProcPtr;
+    }
+    process->nextProcPtr = NULL;
+    process->prevProcPtr = NULL;
+    if (queue->head == NULL) {
+        ReadyBitmap &= ~(1 << index);
     }
     if (DEBUG && debugflag) {
         USLOSS_Console("removeFromReadyList(): Process %d removed from"
@@ -1123,7 +2118,8 @@ void removeFromReadyList(procPtr process) {
 /*------------------------------------------------------------------
 |  Function unblockZappers
 |
-|  Purpose:  Unblocks all processes that zapped a process.
+|  Purpose:  Unblocks all processes that zapped a process, in the order
+|            they called zap.
 |  
 |  Parameters:
 |            procPtr ptr - head of linked list of processes that zapped
@@ -1135,10 +2131,693 @@ void removeFromReadyList(procPtr process) {
 |                 to the ready list.
 *-------------------------------------------------------------------*/
 void unblockZappers(procPtr ptr) {
-    if (ptr == NULL) {
-        return;
+    while (ptr != NULL) {
+        if (TRACE) {
+            traceEvent(TRACE_UNBLOCK, ptr->pid, Current->pid, 0);
+        }
+        addBlockedTime(ptr);
+        ptr->status = READY;
+        ptr->blockedOn = NULL;
+        addProcToReadyList(ptr);
+        ptr = ptr->nextWhoZapped;
     }
-    unblockZappers(ptr->nextWhoZapped);
-    ptr->status = READY;
-    addProcToReadyList(ptr);
 } /* unblockZappers */
+
+/*------------------------------------------------------------------
+|  Function setPriority
+|
+|  Purpose:  Changes the effective priority of a process, moving it to
+|            the back of its new ready queue if it is on the ready list.
+|
+|  Parameters:
+|            procPtr proc - the process to change
+|            int priority - the new priority
+|
+|  Returns:  void
+|
+|  Side Effects:  proc->priority is changed, ReadyList may change
+*-------------------------------------------------------------------*/
+void setPriority(procPtr proc, int priority) {
+    if (proc->priority == priority) {
+        return;
+    }
+    if (proc->status == READY || proc->status == RUNNING) {
+        removeFromReadyList(proc);
+        proc->priority = priority;
+        addProcToReadyList(proc);
+    } else {
+        proc->priority = priority;
+    }
+} /* setPriority */
+
+/*------------------------------------------------------------------
+|  Function mlfqBoostAll
+|
+|  Purpose:  MLFQ anti-starvation reset. Returns every process to the
+|            priority it was forked with.
+|
+|  Parameters:  none
+|
+|  Returns:  void
+|
+|  Side Effects:  priorities in ProcTable and ReadyList may change
+*-------------------------------------------------------------------*/
+void mlfqBoostAll() {
+    for (int i = 0; i < MAXPROC; i++) {
+        if (ProcTable[i].status != EMPTY && ProcTable[i].status != QUIT) {
+            ProcTable[i].ownPriority = ProcTable[i].basePriority;
+            updatePriority(&ProcTable[i], 0);
+        }
+    }
+    lastBoostTime = USLOSS_Clock();
+} /* mlfqBoostAll */
+
+/*------------------------------------------------------------------
+|  Function inheritedPriority
+|
+|  Purpose:  Computes the priority a process should run at: the best of
+|            its own priority and the priorities of the processes blocked
+|            on it, which are its zappers, its parent if JOIN_BLOCKED,
+|            and its blockMeOn waiters.
+|
+|  Parameters:
+|            procPtr proc - the process
+|
+|  Returns:  int - the effective priority
+|
+|  Side Effects:  none
+*-------------------------------------------------------------------*/
+int inheritedPriority(procPtr proc) {
+    int priority = proc->ownPriority;
+    procPtr ptr;
+
+    if (proc->status == QUIT) {
+        return priority;
+    }
+    for (ptr = proc->whoZapped; ptr != NULL; ptr = ptr->nextWhoZapped) {
+        if (ptr->blockedOn == proc && ptr->priority < priority) {
+            priority = ptr->priority;
+        }
+    }
+    for (ptr = proc->waiters; ptr != NULL; ptr = ptr->nextWaiter) {
+        if (ptr->status > ZAP_BLOCKED && ptr->priority < priority) {
+            priority = ptr->priority;
+        }
+    }
+    ptr = proc->parentPtr;
+    if (ptr != NULL && ptr->status == JOIN_BLOCKED &&
+            ptr->priority < priority) {
+        priority = ptr->priority;
+    }
+    return priority;
+} /* inheritedPriority */
+
+/*------------------------------------------------------------------
+|  Function updatePriority
+|
+|  Purpose:  Recomputes the effective priority of a process and, if it
+|            changed, of the processes it is blocked on in turn, so a
+|            priority is passed down a chain of waiters.
+|
+|  Parameters:
+|            procPtr proc - the process to update
+|            int depth - length of the chain so far, bounds a cycle
+|
+|  Returns:  void
+|
+|  Side Effects:  priorities in ProcTable and ReadyList may change
+*-------------------------------------------------------------------*/
+void updatePriority(procPtr proc, int depth) {
+    int priority = proc->ownPriority;
+
+    if (priorityInheritance) {
+        priority = inheritedPriority(proc);
+    }
+    if (priority == proc->priority) {
+        return;
+    }
+    setPriority(proc, priority);
+    if (!priorityInheritance || depth >= MAXPROC) {
+        return;
+    }
+    if (proc->blockedOn != NULL) {
+        updatePriority(proc->blockedOn, depth + 1);
+    }
+    if (proc->status == JOIN_BLOCKED) {
+        for (procPtr child = proc->childProcPtr; child != NULL;
+                child = child->nextSiblingPtr) {
+            updatePriority(child, depth + 1);
+        }
+    }
+} /* updatePriority */
+
+/*------------------------------------------------------------------
+|  Function updateChildPriorities
+|
+|  Purpose:  Recomputes the priorities of a process's active children,
+|            after it blocks in join or is woken from it.
+|
+|  Parameters:
+|            procPtr parent - the parent process
+|
+|  Returns:  void
+|
+|  Side Effects:  priorities in ProcTable and ReadyList may change
+*-------------------------------------------------------------------*/
+void updateChildPriorities(procPtr parent) {
+    for (procPtr child = parent->childProcPtr; child != NULL;
+            child = child->nextSiblingPtr) {
+        updatePriority(child, 0);
+    }
+} /* updateChildPriorities */
+
+/*------------------------------------------------------------------
+|  Function addToWaiterList
+|
+|  Purpose:  Records that a process is blocked in blockMeOn waiting on
+|            another process
+|
+|  Parameters:
+|            procPtr target - the process being waited on
+|            procPtr waiter - the process calling blockMeOn
+|
+|  Returns:  void
+|
+|  Side Effects: waiter is added to the front of target's waiters list
+*-------------------------------------------------------------------*/
+void addToWaiterList(procPtr target, procPtr waiter) {
+    waiter->blockedOn = target;
+    waiter->prevWaiter = NULL;
+    waiter->nextWaiter = target->waiters;
+    if (target->waiters != NULL) {
+        target->waiters->prevWaiter = waiter;
+    }
+    target->waiters = waiter;
+} /* addToWaiterList */
+
+/*------------------------------------------------------------------
+|  Function removeFromWaiterList
+|
+|  Purpose:  Unlinks a process from the waiters list of the process it
+|            is blocked on in O(1)
+|
+|  Parameters:
+|            procPtr waiter - the waiting process
+|
+|  Returns:  void
+|
+|  Side Effects: waiter->blockedOn is cleared
+*-------------------------------------------------------------------*/
+void removeFromWaiterList(procPtr waiter) {
+    if (waiter->prevWaiter == NULL) {
+        waiter->blockedOn->waiters = waiter->nextWaiter;
+    } else {
+        waiter->prevWaiter->nextWaiter = waiter->nextWaiter;
+    }
+    if (waiter->nextWaiter != NULL) {
+        waiter->nextWaiter->prevWaiter = waiter->prevWaiter;
+    }
+    waiter->nextWaiter = NULL;
+    waiter->prevWaiter = NULL;
+    waiter->blockedOn = NULL;
+} /* removeFromWaiterList */
+
+/*------------------------------------------------------------------
+|  Function rtUtilization
+|
+|  Purpose:  Computes the share of the CPU a real-time process reserves
+|
+|  Parameters:
+|            int period - the period in microseconds
+|            int budget - the budget per period in microseconds
+|
+|  Returns:  int - the share in permille, rounded up
+|
+|  Side Effects: none
+*-------------------------------------------------------------------*/
+int rtUtilization(int period, int budget) {
+    return (int) (((long long) budget * 1000 + period - 1) / period);
+} /* rtUtilization */
+
+/*------------------------------------------------------------------
+|  Function removeFromRTList
+|
+|  Purpose:  Removes a quitting real-time process from RTList and gives
+|            back its CPU reservation
+|
+|  Parameters:
+|            procPtr proc - the real-time process
+|
+|  Returns:  void
+|
+|  Side Effects: RTList and rtReserved are changed
+*-------------------------------------------------------------------*/
+void removeFromRTList(procPtr proc) {
+    procPtr *link = &RTList;
+
+    while (*link != NULL && *link != proc) {
+        link = &(*link)->nextRTProc;
+    }
+    if (*link != NULL) {
+        *link = proc->nextRTProc;
+        proc->nextRTProc = NULL;
+        rtReserved -= rtUtilization(proc->period, proc->budget);
+    }
+} /* removeFromRTList */
+
+/*------------------------------------------------------------------
+|  Function releaseRTProcs
+|
+|  Purpose:  Starts the next period of every real-time process whose
+|            deadline has passed. A process that had not finished its job
+|            by then has missed the deadline, and one that used more than
+|            its budget without being throttled has overrun. Its budget is
+|            refilled and it is made ready if it was throttled or waiting
+|            for the period. Called on every clock interrupt.
+|
+|  Parameters:  none
+|
+|  Returns:  int - 1 if the real-time ready queue changed, 0 otherwise
+|
+|  Side Effects: deadlines, budgets and ReadyList may change
+*-------------------------------------------------------------------*/
+int releaseRTProcs() {
+    int now = USLOSS_Clock();
+    int released = 0;
+
+    for (procPtr proc = RTList; proc != NULL; proc = proc->nextRTProc) {
+        int used = proc->budgetUsed;
+
+        if (now < proc->deadline) {
+            continue;
+        }
+        if (proc == Current) {
+            used += readSliceTime();
+        }
+        if (proc->status != PERIOD_BLOCKED) {
+            proc->stats.deadlineMisses++;
+        }
+        if (proc->status != THROTTLED && used > proc->budget) {
+            proc->stats.overruns++;
+        }
+        while (proc->deadline <= now) {
+            proc->deadline += proc->period;
+        }
+
+        // time the current process ran before the new period is not charged
+        proc->budgetUsed = proc == Current ? -readSliceTime() : 0;
+
+        if (proc->status == THROTTLED || proc->status == PERIOD_BLOCKED) {
+            if (TRACE) {
+                traceEvent(TRACE_UNBLOCK, proc->pid, -1, 0);
+            }
+            addBlockedTime(proc);
+            proc->status = READY;
+            addProcToReadyList(proc);
+            clockWaiting--;
+            released = 1;
+        } else if (proc->status == READY || proc->status == RUNNING) {
+            // keep the real-time queue in deadline order
+            removeFromReadyList(proc);
+            addProcToReadyList(proc);
+            released = 1;
+        }
+    }
+    return released;
+} /* releaseRTProcs */
+
+/*------------------------------------------------------------------
+|  Function addBlockedTime
+|
+|  Purpose:  Adds the time since a process blocked to the statistic
+|            for the status it blocked on. Called just before a blocked
+|            process is made READY.
+|
+|  Parameters:
+|            procPtr proc - the process being unblocked
+|
+|  Returns:  void
+|
+|  Side Effects:  proc->stats is changed
+*-------------------------------------------------------------------*/
+void addBlockedTime(procPtr proc) {
+    int blockedTime = USLOSS_Clock() - proc->blockedSince;
+
+    switch (proc->status) {
+        case JOIN_BLOCKED : proc->stats.joinBlockedTime += blockedTime;
+            break;
+        case ZAP_BLOCKED : proc->stats.zapBlockedTime += blockedTime;
+            break;
+        default : proc->stats.blockMeTime += blockedTime;
+    }
+} /* addBlockedTime */
+
+/*------------------------------------------------------------------
+|  Function getProcStats
+|
+|  Purpose:  Copies the scheduler statistics of a process. The CPU time
+|            of the current process includes its current time slice.
+|
+|  Parameters:
+|            int pid - the process to query
+|            procStats *stats (OUT) - where the statistics are stored
+|
+|  Returns:  int - 0 on success, -1 if pid is not a process
+|
+|  Side Effects:  none
+*-------------------------------------------------------------------*/
+int getProcStats(int pid, procStats *stats) {
+    procPtr proc = getProc(pid);
+
+    if (proc == NULL) {
+        return -1;
+    }
+    *stats = proc->stats;
+    if (proc == Current) {
+        stats->cpuTime += readSliceTime();
+    }
+    return 0;
+} /* getProcStats */
+
+/*------------------------------------------------------------------
+|  Function getPriority
+|
+|  Purpose:  Returns the priority a process is scheduled at, including
+|            any MLFQ demotion or inherited priority.
+|
+|  Parameters:
+|            int pid - the process to query
+|
+|  Returns:  int - the priority, -1 if pid is not a process
+|
+|  Side Effects:  none
+*-------------------------------------------------------------------*/
+int getPriority(int pid) {
+    procPtr proc = getProc(pid);
+
+    if (proc == NULL) {
+        return -1;
+    }
+    return proc->priority;
+} /* getPriority */
+
+/*------------------------------------------------------------------
+|  Function setTickets
+|
+|  Purpose:  Changes the CPU share of a process in SCHED_STRIDE. The
+|            process's stride changes from its next time slice on.
+|
+|  Parameters:
+|            int pid - the process to change
+|            int tickets - 1 to STRIDE_MAX_TICKETS
+|
+|  Returns:  int - 0 on success, -1 if pid is not a process or tickets
+|            is out of range
+|
+|  Side Effects:  the process's tickets and stride are changed
+*-------------------------------------------------------------------*/
+int setTickets(int pid, int tickets) {
+    procPtr proc = getProc(pid);
+
+    if( (USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0 ) {
+        USLOSS_Console("setTickets(): called while in user mode, by process "
+                       "%d. Halting...\n", Current->pid);
+        USLOSS_Halt(1);
+    }
+    if (proc == NULL || tickets < 1 || tickets > STRIDE_MAX_TICKETS) {
+        return -1;
+    }
+    proc->tickets = tickets;
+    proc->stride = STRIDE1 / tickets;
+    return 0;
+} /* setTickets */
+
+/*------------------------------------------------------------------
+|  Function readyQueueOf
+|
+|  Purpose:  Finds the ready queue a process belongs on. This is its
+|            priority, except that in SCHED_STRIDE priorities 1..5 all
+|            share the stride queue, ReadyList[MAXPRIORITY].
+|
+|  Parameters:
+|            procPtr proc - the process
+|
+|  Returns:  int - the index in ReadyList
+|
+|  Side Effects:  none
+*-------------------------------------------------------------------*/
+int readyQueueOf(procPtr proc) {
+    if (schedMode == SCHED_STRIDE && proc->priority >= MAXPRIORITY &&
+            proc->priority <= MINPRIORITY) {
+        return MAXPRIORITY;
+    }
+    return proc->priority;
+} /* readyQueueOf */
+
+/*------------------------------------------------------------------
+|  Function runsBefore
+|
+|  Purpose:  Orders the real-time queue by deadline and the stride
+|            queue by pass. Processes that tie keep their order.
+|
+|  Parameters:
+|            procPtr proc - a process being added to a ready queue
+|            procPtr other - a process already on the same queue
+|
+|  Returns:  int - 1 if proc goes ahead of other, 0 otherwise
+|
+|  Side Effects:  none
+*-------------------------------------------------------------------*/
+int runsBefore(procPtr proc, procPtr other) {
+    if (proc->priority == RTPRIORITY) {
+        return proc->deadline < other->deadline;
+    }
+    if (readyQueueOf(proc) == MAXPRIORITY && schedMode == SCHED_STRIDE) {
+        return proc->pass < other->pass;
+    }
+    return 0;
+} /* runsBefore */
+
+/*------------------------------------------------------------------
+|  Function chargeStride
+|
+|  Purpose:  Advances a process's pass by its stride for each full time
+|            slice of CPU it used, pro rata. A process still on the
+|            stride queue is moved to its new place in pass order.
+|
+|  Parameters:
+|            procPtr proc - the process being switched out
+|            int usedTime - the CPU time it used, in microseconds
+|
+|  Returns:  void
+|
+|  Side Effects:  proc->pass and ReadyList may change
+*-------------------------------------------------------------------*/
+void chargeStride(procPtr proc, int usedTime) {
+    if (readyQueueOf(proc) != MAXPRIORITY) {
+        return;
+    }
+    proc->pass += proc->stride * usedTime / TIME_SLICE;
+    if (proc->status == READY) {
+        removeFromReadyList(proc);
+        addProcToReadyList(proc);
+    }
+} /* chargeStride */
+
+/*------------------------------------------------------------------
+|  Function initStackPool
+|
+|  Purpose:  Reserves an arena for each stack size class and puts every
+|            stack in it on the class's free list. When STACK_GUARD is
+|            set, the page below each stack is made inaccessible so a
+|            stack overflow faults instead of corrupting a neighbor.
+|
+|  Parameters:  none
+|
+|  Returns:  void
+|
+|  Side Effects:  StackPool is initialized. Halts USLOSS if the memory
+|                 cannot be reserved.
+*-------------------------------------------------------------------*/
+void initStackPool() {
+    int guardSize = STACK_GUARD ? getpagesize() : 0;
+
+    for (int i = 0; i < NUMSTACKCLASSES; i++) {
+        stackClass *pool = &StackPool[i];
+        pool->stackSize = USLOSS_MIN_STACK << i;
+        unsigned int span = guardSize + pool->stackSize;
+
+        pool->arena = mmap(NULL, span * STACKSPERCLASS,
+                           PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON,
+                           -1, 0);
+        if (pool->arena == MAP_FAILED) {
+            USLOSS_Console("initStackPool(): mmap fail!  Halting...\n");
+            USLOSS_Halt(1);
+        }
+
+        // push in reverse so the lowest addressed stacks are used first
+        pool->numFree = 0;
+        for (int j = STACKSPERCLASS - 1; j >= 0; j--) {
+            if (guardSize > 0) {
+                mprotect(pool->arena + j * span, guardSize, PROT_NONE);
+            }
+            pool->freeList[pool->numFree++] = j;
+        }
+        pool->highWater = 0;
+    }
+} /* initStackPool */
+
+/*------------------------------------------------------------------
+|  Function allocStack
+|
+|  Purpose:  Gets a stack for a process from the smallest size class
+|            that fits. Stacks larger than every class, or requested when
+|            the class is exhausted, are malloc'd.
+|
+|  Parameters:
+|            procPtr proc - the process the stack is for
+|            int stacksize - the requested stack size
+|
+|  Returns:  char * - the lowest address of the stack
+|
+|  Side Effects:  proc->stackSize and proc->stackPool are set. Halts
+|                 USLOSS if malloc fails.
+*-------------------------------------------------------------------*/
+char *allocStack(procPtr proc, int stacksize) {
+    int guardSize = STACK_GUARD ? getpagesize() : 0;
+    char *stack;
+
+    for (int i = 0; i < NUMSTACKCLASSES; i++) {
+        stackClass *pool = &StackPool[i];
+        if (stacksize <= pool->stackSize && pool->numFree > 0) {
+            int index = pool->freeList[--pool->numFree];
+            int inUse = STACKSPERCLASS - pool->numFree;
+
+            if (inUse > pool->highWater) {
+                pool->highWater = inUse;
+            }
+            proc->stackPool = i;
+            proc->stackSize = pool->stackSize;
+            return pool->arena + index * (guardSize + pool->stackSize) +
+                   guardSize;
+        }
+    }
+
+    if ((stack = malloc(stacksize)) == NULL) {
+        USLOSS_Console("fork1(): malloc fail!  Halting...\n");
+        USLOSS_Halt(1);
+    }
+    mallocStacks++;
+    proc->stackPool = -1;
+    proc->stackSize = stacksize;
+    return stack;
+} /* allocStack */
+
+/*------------------------------------------------------------------
+|  Function freeStack
+|
+|  Purpose:  Returns a process's stack to its size class, or frees it
+|            if it was malloc'd.
+|
+|  Parameters:
+|            procPtr proc - the process whose stack is released
+|
+|  Returns:  void
+|
+|  Side Effects:  The stack is pushed on its class's free list.
+*-------------------------------------------------------------------*/
+void freeStack(procPtr proc) {
+    int guardSize = STACK_GUARD ? getpagesize() : 0;
+
+    if (proc->stackPool < 0) {
+        free(proc->stack);
+        return;
+    }
+    stackClass *pool = &StackPool[proc->stackPool];
+    int index = (proc->stack - guardSize - pool->arena) /
+                (guardSize + pool->stackSize);
+    pool->freeList[pool->numFree++] = index;
+} /* freeStack */
+
+/*------------------------------------------------------------------
+|  Function dumpStackPool
+|
+|  Purpose:  Prints the stacks in use and the high-water mark for each
+|            stack size class, and the number of malloc'd stacks.
+|
+|  Parameters:  none
+|
+|  Returns:  void
+|
+|  Side Effects:  Printed to screen using USLOSS_Console
+*-------------------------------------------------------------------*/
+void dumpStackPool() {
+    USLOSS_Console("\n  StackSize  InUse  HighWater  Capacity\n");
+    for (int i = 0; i < NUMSTACKCLASSES; i++) {
+        USLOSS_Console("%11d %6d %10d %9d\n", StackPool[i].stackSize,
+                       STACKSPERCLASS - StackPool[i].numFree,
+                       StackPool[i].highWater, STACKSPERCLASS);
+    }
+    USLOSS_Console("malloc'd stacks: %d\n", mallocStacks);
+} /* dumpStackPool */
+
+/*------------------------------------------------------------------
+|  Function traceEvent
+|
+|  Purpose:  Records a scheduler event in the trace ring. Once the ring
+|            is full the oldest record is overwritten.
+|
+|  Parameters:
+|            int type - TRACE_FORK, TRACE_SWITCH, etc. from trace.h
+|            int pid - the process the event is about
+|            int otherPid - the second process involved, or -1
+|            int arg - priority, status, etc. depending on type
+|
+|  Returns:  void
+|
+|  Side Effects:  TraceRing and traceCount are changed
+*-------------------------------------------------------------------*/
+void traceEvent(int type, int pid, int otherPid, int arg) {
+    traceRecord *rec = &TraceRing[traceCount++ % TRACE_SIZE];
+
+    rec->time = USLOSS_Clock();
+    rec->type = type;
+    rec->pid = pid;
+    rec->otherPid = otherPid;
+    rec->arg = arg;
+} /* traceEvent */
+
+/*------------------------------------------------------------------
+|  Function writeTrace
+|
+|  Purpose:  Writes the trace ring to TRACE_FILE, oldest record first,
+|            for the traceAnalyzer tool.
+|
+|  Parameters:  none
+|
+|  Returns:  void
+|
+|  Side Effects:  TRACE_FILE is created or overwritten
+*-------------------------------------------------------------------*/
+void writeTrace() {
+    traceHeader header;
+    FILE *file;
+    unsigned int first = 0;
+
+    if ((file = fopen(TRACE_FILE, "wb")) == NULL) {
+        USLOSS_Console("writeTrace(): could not open %s\n", TRACE_FILE);
+        return;
+    }
+    header.magic = TRACE_MAGIC;
+    header.version = TRACE_VERSION;
+    header.count = traceCount < TRACE_SIZE ? traceCount : TRACE_SIZE;
+    header.dropped = traceCount - header.count;
+    if (traceCount > TRACE_SIZE) {
+        first = traceCount % TRACE_SIZE;
+    }
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(&TraceRing[first], sizeof(traceRecord), header.count - first,
+           file);
+    fwrite(TraceRing, sizeof(traceRecord), first, file);
+    fclose(file);
+} /* writeTrace */
@@ -25,18 +25,45 @@
 
 #define MAXARG       100
 
+/*
+ * Maximum number of kernel tasks, and the value a task function returns
+ * to remove itself.
+ */
+
+#define MAXTASKS     32
+#define TASK_DONE    1
+
 /*
  * Maximum number of syscalls.
  */
 
 #define MAXSYSCALLS  50
 
+/*
+ * Scheduler statistics for a process, returned by getProcStats.
+ * Times are in microseconds.
+ */
+typedef struct procStats {
+    int cpuTime;              /* total CPU time used */
+    int dispatches;           /* times the process was given the CPU */
+    int voluntarySwitches;    /* switched out because it blocked or quit */
+    int involuntarySwitches;  /* switched out while still runnable */
+    int joinBlockedTime;      /* time spent JOIN_BLOCKED */
+    int zapBlockedTime;       /* time spent ZAP_BLOCKED */
+    int blockMeTime;          /* time spent in blockMe (mailboxes, etc.) */
+    int overruns;             /* real-time periods the budget ran out in */
+    int deadlineMisses;       /* real-time periods that ended unfinished */
+} procStats;
+
 
 /* 
  * Function prototypes for this phase.
  */
 extern int   fork1(char *name, int(*func)(char *), char *arg,
                            int stacksize, int priority);
+extern int   fork1RT(char *name, int(*func)(char *), char *arg,
+                     int stacksize, int period, int budget);
+extern int   waitPeriod(void);
 extern int   join(int *status);
 extern void  quit(int status);
 extern int   zap(int pid);
@@ -44,11 +71,23 @@ extern int   isZapped(void);
 extern int   getpid(void);
 extern void  dumpProcesses(void);
 extern int   blockMe(int block_status);
+extern int   blockMeOn(int block_status, int pid);
 extern int   unblockProc(int pid);
+extern int   unblockMany(int pids[], int n);
+extern int   unblockHandoff(int pid);
 extern int   readCurStartTime(void);
 extern void  timeSlice(void);
 extern void  dispatcher(void);
 extern int   readtime(void);
+extern int   getProcStats(int pid, procStats *stats);
+extern int   getPriority(int pid);
+extern int   setTickets(int pid, int tickets);
+extern void  dumpStackPool(void);
+extern int   taskCreate(char *name, int(*func)(void *), void *arg);
+extern int   taskPost(int tid);
+
+/* nonzero to run processes at the priority of those blocked on them */
+extern int   priorityInheritance;
 
 extern void  p1_fork(int pid);
 extern void  p1_quit(int pid);
@@ -0,0 +1,64 @@
+/* Tests getProcStats.
+ *
+ * start1 creates XXp1 at priority 3 and joins with it. XXp1 reads the
+ * statistics of its parent, which is JOIN_BLOCKED, and of itself.
+ * After the join start1 reads its own statistics again.
+ *
+ * getProcStats is also called with the pid of a process that has been
+ * cleaned up and should return -1.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int XXp1(char *);
+int parentPid;
+
+int start1(char *arg)
+{
+    int status, pid1, kidpid, result;
+    procStats stats;
+
+    printf("start1(): started\n");
+    parentPid = getpid();
+    pid1 = fork1("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 3);
+    printf("start1(): after fork of child %d\n", pid1);
+
+    printf("start1(): performing join\n");
+    kidpid = join(&status);
+    printf("start1(): exit status for child %d is %d\n", kidpid, status);
+
+    getProcStats(getpid(), &stats);
+    printf("start1(): dispatches = %d, voluntary = %d, involuntary = %d\n",
+           stats.dispatches, stats.voluntarySwitches,
+           stats.involuntarySwitches);
+    printf("start1(): used CPU = %s, was join blocked = %s\n",
+           stats.cpuTime > 0 ? "yes" : "no",
+           stats.joinBlockedTime > 0 ? "yes" : "no");
+
+    result = getProcStats(kidpid, &stats);
+    printf("start1(): getProcStats of joined child returned %d\n", result);
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int XXp1(char *arg)
+{
+    procStats stats;
+
+    printf("XXp1(): started\n");
+    getProcStats(parentPid, &stats);
+    printf("XXp1(): parent dispatches = %d, voluntary = %d, "
+           "involuntary = %d\n", stats.dispatches, stats.voluntarySwitches,
+           stats.involuntarySwitches);
+
+    getProcStats(getpid(), &stats);
+    printf("XXp1(): my dispatches = %d, used CPU = %s, readtime matches = %s\n",
+           stats.dispatches, stats.cpuTime > 0 ? "yes" : "no",
+           readtime() >= stats.cpuTime ? "yes" : "no");
+
+    quit(-3);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* Stress test for the child, quit child and zapper lists.
+ *
+ * start1 creates Parent at priority 4 and joins with it.
+ *
+ * Parent runs ROUNDS rounds. Each round it forks KIDS children and then
+ * joins with all of them. On even rounds the children have priority 3,
+ * so each one runs and quits as soon as it is forked and the quit child
+ * list grows to KIDS entries. On odd rounds the children have priority
+ * 5, so the child list grows to KIDS entries and the children only run
+ * once Parent blocks in join.
+ *
+ * Finally Parent forks a Victim at priority 5 and KIDS Zappers at
+ * priority 3 that all zap the Victim.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define ROUNDS 100
+#define KIDS   40
+
+int Parent(char *);
+int Child(char *);
+int Zapper(char *);
+int Victim(char *);
+
+int victimPid;
+
+int start1(char *arg)
+{
+    int status, pid1, kidpid;
+
+    printf("start1(): started\n");
+    pid1 = fork1("Parent", Parent, NULL, USLOSS_MIN_STACK, 4);
+    printf("start1(): after fork of child %d\n", pid1);
+
+    printf("start1(): performing join\n");
+    kidpid = join(&status);
+    printf("start1(): exit status for child %d is %d\n", kidpid, status);
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Parent(char *arg)
+{
+    int status, forks = 0, joins = 0, statusSum = 0, zapOk = 0;
+    char buf[10];
+
+    printf("Parent(): started\n");
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < KIDS; i++) {
+            sprintf(buf, "%d", i);
+            if (fork1("Child", Child, buf, USLOSS_MIN_STACK,
+                      round % 2 == 0 ? 3 : 5) > 0) {
+                forks++;
+            }
+        }
+        for (int i = 0; i < KIDS; i++) {
+            if (join(&status) > 0) {
+                joins++;
+                statusSum += status;
+            }
+        }
+    }
+    printf("Parent(): forked %d children, joined %d, status sum = %d\n",
+           forks, joins, statusSum);
+
+    victimPid = fork1("Victim", Victim, NULL, USLOSS_MIN_STACK, 5);
+    for (int i = 0; i < KIDS; i++) {
+        fork1("Zapper", Zapper, NULL, USLOSS_MIN_STACK, 3);
+    }
+    for (int i = 0; i < KIDS + 1; i++) {
+        join(&status);
+        if (status == 0) {
+            zapOk++;
+        }
+    }
+    printf("Parent(): %d zappers returned 0\n", zapOk);
+
+    quit(-3);
+    return 0;
+}
+
+int Child(char *arg)
+{
+    quit(atoi(arg));
+    return 0;
+}
+
+int Zapper(char *arg)
+{
+    quit(zap(victimPid));
+    return 0;
+}
+
+int Victim(char *arg)
+{
+    quit(1);
+    return 0;
+}
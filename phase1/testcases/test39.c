@@ -0,0 +1,85 @@
+/* Tests priority inheritance.
+ *
+ * start1 turns on priority inheritance, then creates Low at priority 5
+ * and Mid at priority 3 and zaps Low. Low runs at start1's priority, so
+ * it quits before Mid ever runs.
+ *
+ * start1 then creates Holder at priority 5 and Busy at priority 3 and
+ * blocks in blockMeOn waiting on Holder. Holder runs ahead of Busy and
+ * unblocks start1.
+ *
+ * Without priority inheritance Mid and Busy would run first.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Low(char *);
+int Mid(char *);
+int Holder(char *);
+int Busy(char *);
+
+int start1Pid;
+
+int start1(char *arg)
+{
+    int status, lowPid, holderPid, kidpid, result;
+
+    printf("start1(): started\n");
+    priorityInheritance = 1;
+    start1Pid = getpid();
+
+    lowPid = fork1("Low", Low, "Low", USLOSS_MIN_STACK, 5);
+    fork1("Mid", Mid, "Mid", USLOSS_MIN_STACK, 3);
+    printf("start1(): zapping Low\n");
+    result = zap(lowPid);
+    printf("start1(): zap returned %d\n", result);
+    for (int i = 0; i < 2; i++) {
+        kidpid = join(&status);
+        printf("start1(): joined with child %d, status %d\n", kidpid, status);
+    }
+
+    holderPid = fork1("Holder", Holder, "Holder", USLOSS_MIN_STACK, 5);
+    fork1("Busy", Busy, "Busy", USLOSS_MIN_STACK, 3);
+    printf("start1(): blocking on Holder\n");
+    result = blockMeOn(20, holderPid);
+    printf("start1(): blockMeOn returned %d\n", result);
+    for (int i = 0; i < 2; i++) {
+        kidpid = join(&status);
+        printf("start1(): joined with child %d, status %d\n", kidpid, status);
+    }
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Low(char *arg)
+{
+    printf("Low(): running\n");
+    quit(1);
+    return 0;
+}
+
+int Mid(char *arg)
+{
+    printf("Mid(): running\n");
+    quit(2);
+    return 0;
+}
+
+int Holder(char *arg)
+{
+    printf("Holder(): running, unblocking start1\n");
+    unblockProc(start1Pid);
+    printf("Holder(): after unblockProc\n");
+    quit(3);
+    return 0;
+}
+
+int Busy(char *arg)
+{
+    printf("Busy(): running\n");
+    quit(4);
+    return 0;
+}
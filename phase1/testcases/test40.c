@@ -0,0 +1,88 @@
+/* Tests real-time (EDF) processes.
+ *
+ * start1 creates Sampler, a real-time process with a 100 ms period and a
+ * 30 ms budget that runs JOBS short jobs, one per period. Sampler runs
+ * as soon as it is forked, ahead of start1 at priority 1.
+ *
+ * fork1RT is also called with an invalid budget, and with a budget that
+ * would reserve more than RT_MAX_UTILIZATION of the CPU. waitPeriod
+ * fails in start1, which is not a real-time process.
+ *
+ * Overrunner is a real-time process with a 20 ms budget that never
+ * calls waitPeriod. It spins until its overrun has been counted.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define PERIOD 100000
+#define JOBS   5
+
+int Sampler(char *);
+int Overrunner(char *);
+void spin(int usecs);
+
+int start1(char *arg)
+{
+    int status, result;
+
+    printf("start1(): started\n");
+    result = fork1RT("Bad", Sampler, NULL, USLOSS_MIN_STACK, PERIOD, 0);
+    printf("start1(): fork1RT with zero budget returned %d\n", result);
+
+    fork1RT("Sampler", Sampler, NULL, USLOSS_MIN_STACK, PERIOD, 30000);
+    printf("start1(): forked Sampler\n");
+
+    result = fork1RT("Greedy", Sampler, NULL, USLOSS_MIN_STACK, PERIOD,
+                     70000);
+    printf("start1(): fork1RT beyond the reservation returned %d\n", result);
+
+    fork1RT("Overrunner", Overrunner, NULL, USLOSS_MIN_STACK, PERIOD, 20000);
+    printf("start1(): forked Overrunner\n");
+
+    result = waitPeriod();
+    printf("start1(): waitPeriod returned %d\n", result);
+    for (int i = 0; i < 2; i++) {
+        join(&status);
+    }
+    printf("start1(): real-time processes quit\n");
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Sampler(char *arg)
+{
+    procStats stats;
+
+    printf("Sampler(): started\n");
+    for (int i = 0; i < JOBS; i++) {
+        spin(5000);
+        waitPeriod();
+    }
+    getProcStats(getpid(), &stats);
+    printf("Sampler(): %d jobs done, overruns = %d\n", JOBS, stats.overruns);
+    quit(1);
+    return 0;
+}
+
+int Overrunner(char *arg)
+{
+    procStats stats;
+
+    printf("Overrunner(): started\n");
+    do {
+        getProcStats(getpid(), &stats);
+    } while (stats.overruns == 0);
+    printf("Overrunner(): went over its budget\n");
+    quit(2);
+    return 0;
+}
+
+void spin(int usecs)
+{
+    int start = USLOSS_Clock();
+
+    while (USLOSS_Clock() - start < usecs)
+        ;
+}
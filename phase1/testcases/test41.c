@@ -0,0 +1,68 @@
+/* Tests SCHED_STRIDE proportional-share scheduling.
+ *
+ * start1 switches to stride scheduling and creates Busy at priority 2
+ * and Starved at priority 5. Busy spins until Starved has run. Under
+ * strict priority Starved would never run while Busy is runnable; with
+ * stride scheduling it gets its share of the CPU.
+ *
+ * setTickets is called with an invalid ticket count and pid.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define SCHED_STRIDE 2  /* from kernel.h */
+
+int Busy(char *);
+int Starved(char *);
+
+extern int schedMode;
+
+volatile int starvedRan = 0;
+volatile int busyDone = 0;
+
+int start1(char *arg)
+{
+    int status, busyPid, result;
+
+    printf("start1(): started\n");
+    schedMode = SCHED_STRIDE;
+
+    busyPid = fork1("Busy", Busy, NULL, USLOSS_MIN_STACK, 2);
+    fork1("Starved", Starved, NULL, USLOSS_MIN_STACK, 5);
+
+    result = setTickets(busyPid, 0);
+    printf("start1(): setTickets with 0 tickets returned %d\n", result);
+    result = setTickets(busyPid + 100, 10);
+    printf("start1(): setTickets of a bad pid returned %d\n", result);
+    result = setTickets(busyPid, 20);
+    printf("start1(): setTickets(Busy, 20) returned %d\n", result);
+
+    for (int i = 0; i < 2; i++) {
+        join(&status);
+    }
+    printf("start1(): done\n");
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Busy(char *arg)
+{
+    while (!starvedRan)
+        ;
+    printf("Busy(): Starved ran while Busy was runnable\n");
+    busyDone = 1;
+    quit(1);
+    return 0;
+}
+
+int Starved(char *arg)
+{
+    starvedRan = 1;
+    while (!busyDone)
+        ;
+    printf("Starved(): done\n");
+    quit(2);
+    return 0;
+}
@@ -0,0 +1,64 @@
+/* Tests unblockMany.
+ *
+ * start1 creates three Waiters at priority 3, which block in blockMe,
+ * and a Waker at priority 4. Waker unblocks all of them, plus a pid that
+ * does not exist, with one call to unblockMany. The Waiters all run
+ * before Waker continues, but Waker is switched out only once.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define WAITERS 3
+
+int Waiter(char *);
+int Waker(char *);
+
+int waiterPids[WAITERS + 1];
+
+int start1(char *arg)
+{
+    int status;
+    char name[10];
+
+    printf("start1(): started\n");
+    for (int i = 0; i < WAITERS; i++) {
+        sprintf(name, "Waiter%d", i);
+        waiterPids[i] = fork1(name, Waiter, name, USLOSS_MIN_STACK, 3);
+    }
+    waiterPids[WAITERS] = waiterPids[WAITERS - 1] + 100;
+    fork1("Waker", Waker, NULL, USLOSS_MIN_STACK, 4);
+
+    for (int i = 0; i < WAITERS + 1; i++) {
+        join(&status);
+    }
+    printf("start1(): done\n");
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Waiter(char *arg)
+{
+    printf("%s(): blocking\n", arg);
+    blockMe(20);
+    printf("%s(): unblocked\n", arg);
+    quit(1);
+    return 0;
+}
+
+int Waker(char *arg)
+{
+    procStats before, after;
+    int result;
+
+    printf("Waker(): unblocking %d waiters and a bad pid\n", WAITERS);
+    getProcStats(getpid(), &before);
+    result = unblockMany(waiterPids, WAITERS + 1);
+    getProcStats(getpid(), &after);
+    printf("Waker(): unblockMany returned %d\n", result);
+    printf("Waker(): switched out %d time(s) by the wakeups\n",
+           after.involuntarySwitches - before.involuntarySwitches);
+    quit(2);
+    return 0;
+}
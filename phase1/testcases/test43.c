@@ -0,0 +1,64 @@
+/* Tests unblockHandoff.
+ *
+ * start1 creates a Server and a Client at the same priority. The Server
+ * blocks twice. The first time the Client wakes it with unblockProc, so
+ * the Client keeps running until it blocks for the reply. The second time
+ * it uses unblockHandoff, so the Server runs right away. unblockHandoff of
+ * a pid that does not exist returns -2.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Server(char *);
+int Client(char *);
+
+int serverPid;
+int clientPid;
+
+int start1(char *arg)
+{
+    int status;
+
+    printf("start1(): started\n");
+    serverPid = fork1("Server", Server, NULL, USLOSS_MIN_STACK, 3);
+    clientPid = fork1("Client", Client, NULL, USLOSS_MIN_STACK, 3);
+
+    join(&status);
+    join(&status);
+    printf("start1(): done\n");
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Server(char *arg)
+{
+    printf("Server(): waiting for request 0\n");
+    blockMe(20);
+    printf("Server(): got request 0, replying\n");
+    unblockProc(clientPid);
+
+    printf("Server(): waiting for request 1\n");
+    blockMe(20);
+    printf("Server(): got request 1\n");
+    quit(1);
+    return 0;
+}
+
+int Client(char *arg)
+{
+    printf("Client(): sending request 0 with unblockProc\n");
+    unblockProc(serverPid);
+    printf("Client(): back from unblockProc, waiting for reply\n");
+    blockMe(21);
+
+    printf("Client(): sending request 1 with unblockHandoff\n");
+    unblockHandoff(serverPid);
+    printf("Client(): back from unblockHandoff\n");
+
+    printf("Client(): unblockHandoff of a bad pid returned %d\n",
+           unblockHandoff(serverPid + 100));
+    quit(2);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/* Tests kernel tasks.
+ *
+ * start1 creates a Counter task, which counts its runs, and a Once task,
+ * which removes itself after its first run. It posts Counter three times
+ * and Once twice, then joins with a Checker at priority 5. The task
+ * runner, at priority 1, runs the posts in order before Checker starts,
+ * and Once runs only once. A post from Checker runs the Counter task
+ * before taskPost returns. Posting a removed or unknown task fails, and
+ * taskCreate fails once the task table is full.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Counter(void *);
+int Once(void *);
+int Idle(void *);
+int Checker(char *);
+
+int counterTid, onceTid;
+int count = 0;
+
+int start1(char *arg)
+{
+    int status;
+
+    printf("start1(): started\n");
+    counterTid = taskCreate("Counter", Counter, &count);
+    onceTid = taskCreate("Once", Once, NULL);
+    printf("start1(): created tasks %d and %d\n", counterTid, onceTid);
+
+    for (int i = 0; i < 3; i++) {
+        taskPost(counterTid);
+    }
+    taskPost(onceTid);
+    taskPost(onceTid);
+    printf("start1(): posted Counter 3 times and Once twice\n");
+
+    fork1("Checker", Checker, NULL, USLOSS_MIN_STACK, 5);
+    join(&status);
+    printf("start1(): done\n");
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Counter(void *arg)
+{
+    int *count = arg;
+
+    (*count)++;
+    printf("Counter(): run %d\n", *count);
+    return 0;
+}
+
+int Once(void *arg)
+{
+    printf("Once(): run, removing myself\n");
+    return TASK_DONE;
+}
+
+int Idle(void *arg)
+{
+    return 0;
+}
+
+int Checker(char *arg)
+{
+    int created = 0;
+
+    printf("Checker(): started, Counter has run %d times\n", count);
+    taskPost(counterTid);
+    printf("Checker(): back from taskPost, Counter has run %d times\n",
+           count);
+
+    printf("Checker(): taskPost of removed task returned %d\n",
+           taskPost(onceTid));
+    printf("Checker(): taskPost of bad task returned %d\n",
+           taskPost(MAXTASKS));
+
+    while (taskCreate("Idle", Idle, NULL) >= 0) {
+        created++;
+    }
+    printf("Checker(): created %d more tasks before the table was full\n",
+           created);
+    quit(1);
+    return 0;
+}
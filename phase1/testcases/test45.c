@@ -0,0 +1,83 @@
+/* Tests SCHED_MLFQ multi-level feedback queue scheduling.
+ *
+ * start1 switches to MLFQ scheduling and creates Chatty and Hog, both at
+ * priority 2. Chatty spins until it is demoted for using up its quantum,
+ * and from then on blocks as soon as it runs; the first early block moves
+ * it back up to band 2, and later ones do not move it above the priority
+ * it was forked with.
+ *
+ * Hog spins, and is demoted one band per used-up quantum down to band 5.
+ * Each time its band changes it wakes Chatty, which reports its own band.
+ * The MLFQ_BOOST_PERIOD reset then returns Hog to band 2.
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+#define SCHED_MLFQ 1  /* from kernel.h */
+
+int Chatty(char *);
+int Hog(char *);
+
+extern int schedMode;
+
+int chattyPid;
+volatile int hogDone = 0;
+
+int start1(char *arg)
+{
+    int status;
+
+    printf("start1(): started\n");
+    schedMode = SCHED_MLFQ;
+
+    chattyPid = fork1("Chatty", Chatty, NULL, USLOSS_MIN_STACK, 2);
+    fork1("Hog", Hog, NULL, USLOSS_MIN_STACK, 2);
+    printf("start1(): getPriority of a bad pid returned %d\n",
+           getPriority(chattyPid + 100));
+
+    for (int i = 0; i < 2; i++) {
+        join(&status);
+    }
+    printf("start1(): done\n");
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+}
+
+int Chatty(char *arg)
+{
+    while (getPriority(getpid()) == 2)
+        ;
+    printf("Chatty(): demoted to band %d, now blocking\n",
+           getPriority(getpid()));
+    while (!hogDone) {
+        blockMe(20);
+        printf("Chatty(): woke at band %d\n", getPriority(getpid()));
+    }
+    quit(1);
+    return 0;
+}
+
+int Hog(char *arg)
+{
+    int band = getPriority(getpid());
+    int now;
+
+    while (!hogDone) {
+        now = getPriority(getpid());
+        if (now == band) {
+            continue;
+        }
+        if (now > band) {
+            printf("Hog(): demoted from band %d to %d\n", band, now);
+        } else {
+            printf("Hog(): back at band %d after the boost\n", now);
+            hogDone = 1;
+        }
+        band = now;
+        unblockProc(chattyPid);
+    }
+    quit(2);
+    return 0;
+}
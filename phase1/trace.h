@@ -0,0 +1,41 @@
+/*
+ * Scheduler trace records. The kernel keeps the most recent TRACE_SIZE
+ * records in a ring and writes them to TRACE_FILE at finish(); the
+ * traceAnalyzer host tool reads that file.
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#define TRACE_SIZE    4096            /* records kept, a power of 2 */
+#define TRACE_FILE    "sched.trace"
+#define TRACE_MAGIC   0x54524353      /* "SCRT" */
+#define TRACE_VERSION 1
+
+/* Record types */
+#define TRACE_FORK    1   /* pid forked by otherPid, arg = priority */
+#define TRACE_SWITCH  2   /* pid dispatched, otherPid switched out,
+                             arg = 1 if otherPid was still runnable */
+#define TRACE_BLOCK   3   /* pid blocked, arg = status it blocked on */
+#define TRACE_UNBLOCK 4   /* pid made ready by otherPid */
+#define TRACE_QUIT    5   /* pid quit, arg = quit status */
+#define TRACE_ZAP     6   /* pid zapped otherPid */
+
+typedef struct traceRecord {
+    int time;       /* USLOSS_Clock() when the event happened */
+    int type;       /* one of the record types above */
+    int pid;
+    int otherPid;   /* -1 if there is none */
+    int arg;
+} traceRecord;
+
+/* Header at the start of TRACE_FILE, followed by count records in the
+ * order they were recorded */
+typedef struct traceHeader {
+    int magic;
+    int version;
+    int count;      /* records in the file */
+    int dropped;    /* older records overwritten in the ring */
+} traceHeader;
+
+#endif /* _TRACE_H */
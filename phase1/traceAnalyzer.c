@@ -0,0 +1,244 @@
+/* ------------------------------------------------------------------------
+   traceAnalyzer.c
+
+   Host-side tool that reads the scheduler trace written by phase1 at
+   finish() and prints a run-queue latency histogram, a per-process
+   summary, and optionally per-process timelines.
+
+   Usage: traceAnalyzer [-t] [-p pid] [tracefile]
+          -t      print the timeline of every process
+          -p pid  print the timeline of one process
+------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+#define NUMBUCKETS 32  /* log2 latency buckets, in microseconds */
+
+/* Per-process results */
+typedef struct procSummary {
+    int seen;
+    int readySince;      /* time the process last became ready, -1 if not */
+    int runningSince;    /* time the process was last dispatched, -1 if not */
+    int dispatches;
+    int blocks;
+    long long cpuTime;
+    int waits;           /* latency samples */
+    long long totalLatency;
+    int maxLatency;
+} procSummary;
+
+static char *typeNames[] = {"?", "FORK", "SWITCH", "BLOCK", "UNBLOCK",
+                            "QUIT", "ZAP"};
+
+static int bucketOf(int latency);
+static void printRecord(traceRecord *rec, int pid, int startTime);
+
+int main(int argc, char *argv[]) {
+    char *fileName = TRACE_FILE;
+    int timelines = 0;          // print every timeline
+    int timelinePid = -1;       // print only this timeline
+    traceHeader header;
+    traceRecord *recs;
+    procSummary *procs;
+    int maxPid = 0;
+    int histogram[NUMBUCKETS] = {0};
+    int latencies = 0;
+    FILE *file;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0) {
+            timelines = 1;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            timelinePid = atoi(argv[++i]);
+        } else {
+            fileName = argv[i];
+        }
+    }
+
+    if ((file = fopen(fileName, "rb")) == NULL) {
+        fprintf(stderr, "traceAnalyzer: cannot open %s\n", fileName);
+        return 1;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+            header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+        fprintf(stderr, "traceAnalyzer: %s is not a scheduler trace\n",
+                fileName);
+        return 1;
+    }
+    recs = malloc(sizeof(traceRecord) * (header.count + 1));
+    if (fread(recs, sizeof(traceRecord), header.count, file) !=
+            (size_t) header.count) {
+        fprintf(stderr, "traceAnalyzer: %s is truncated\n", fileName);
+        return 1;
+    }
+    fclose(file);
+
+    if (header.count == 0) {
+        printf("empty trace\n");
+        return 0;
+    }
+
+    for (int i = 0; i < header.count; i++) {
+        if (recs[i].pid > maxPid) {
+            maxPid = recs[i].pid;
+        }
+        if (recs[i].otherPid > maxPid) {
+            maxPid = recs[i].otherPid;
+        }
+    }
+    procs = calloc(maxPid + 1, sizeof(procSummary));
+    for (int i = 0; i <= maxPid; i++) {
+        procs[i].readySince = -1;
+        procs[i].runningSince = -1;
+    }
+
+    /* Replay the trace */
+    for (int i = 0; i < header.count; i++) {
+        traceRecord *rec = &recs[i];
+        procSummary *proc = rec->pid >= 0 ? &procs[rec->pid] : NULL;
+
+        if (proc == NULL) {
+            continue;
+        }
+        proc->seen = 1;
+        switch (rec->type) {
+            case TRACE_FORK :
+            case TRACE_UNBLOCK :
+                proc->readySince = rec->time;
+                break;
+            case TRACE_SWITCH :
+                if (rec->otherPid >= 0) {
+                    procSummary *old = &procs[rec->otherPid];
+                    if (old->runningSince >= 0) {
+                        old->cpuTime += rec->time - old->runningSince;
+                    }
+                    old->runningSince = -1;
+                    old->readySince = rec->arg ? rec->time : -1;
+                }
+                if (proc->readySince >= 0) {
+                    int latency = rec->time - proc->readySince;
+                    histogram[bucketOf(latency)]++;
+                    latencies++;
+                    proc->waits++;
+                    proc->totalLatency += latency;
+                    if (latency > proc->maxLatency) {
+                        proc->maxLatency = latency;
+                    }
+                }
+                proc->readySince = -1;
+                proc->runningSince = rec->time;
+                proc->dispatches++;
+                break;
+            case TRACE_BLOCK :
+            case TRACE_ZAP :
+                proc->blocks++;
+                break;
+        }
+    }
+
+    printf("%d records, %d dropped, %d us from first to last\n",
+           header.count, header.dropped,
+           recs[header.count - 1].time - recs[0].time);
+
+    /* Run-queue latency histogram */
+    printf("\nrun-queue latency (ready to dispatched), %d samples\n",
+           latencies);
+    printf("%12s %8s\n", "us", "count");
+    for (int b = 0; b < NUMBUCKETS; b++) {
+        if (histogram[b] == 0) {
+            continue;
+        }
+        printf("%5d-%-6d %8d ", b == 0 ? 0 : 1 << b, (1 << (b + 1)) - 1,
+               histogram[b]);
+        for (int i = 0; i < 50 * histogram[b] / latencies; i++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+
+    /* Per-process summary */
+    printf("\n%8s %10s %8s %12s %12s %12s\n", "PID", "dispatches",
+           "blocks", "cpu us", "avg wait us", "max wait us");
+    for (int pid = 0; pid <= maxPid; pid++) {
+        procSummary *proc = &procs[pid];
+        if (!proc->seen) {
+            continue;
+        }
+        printf("%8d %10d %8d %12lld %12lld %12d\n", pid, proc->dispatches,
+               proc->blocks, proc->cpuTime,
+               proc->waits ? proc->totalLatency / proc->waits : 0,
+               proc->maxLatency);
+    }
+
+    /* Timelines */
+    for (int pid = 0; pid <= maxPid; pid++) {
+        if (!procs[pid].seen || (!timelines && pid != timelinePid)) {
+            continue;
+        }
+        printf("\ntimeline for pid %d\n", pid);
+        for (int i = 0; i < header.count; i++) {
+            if (recs[i].pid == pid || recs[i].otherPid == pid) {
+                printRecord(&recs[i], pid, recs[0].time);
+            }
+        }
+    }
+
+    free(recs);
+    free(procs);
+    return 0;
+} /* main */
+
+/*
+ * Returns the log2 histogram bucket for a latency in microseconds
+ */
+static int bucketOf(int latency) {
+    int bucket = 0;
+
+    while (latency > 1 && bucket < NUMBUCKETS - 1) {
+        latency >>= 1;
+        bucket++;
+    }
+    return bucket;
+} /* bucketOf */
+
+/*
+ * Prints one record of a process's timeline, with time relative to the
+ * start of the trace
+ */
+static void printRecord(traceRecord *rec, int pid, int startTime) {
+    char *type = rec->type > 0 && rec->type <= TRACE_ZAP ?
+                 typeNames[rec->type] : typeNames[0];
+
+    printf("%10d  %-8s", rec->time - startTime, type);
+    switch (rec->type) {
+        case TRACE_FORK :
+            printf("pid %d forked by %d, priority %d\n", rec->pid,
+                   rec->otherPid, rec->arg);
+            break;
+        case TRACE_SWITCH :
+            if (rec->pid == pid) {
+                printf("dispatched, replacing %d\n", rec->otherPid);
+            } else {
+                printf("switched out for %d%s\n", rec->pid,
+                       rec->arg ? " (preempted)" : "");
+            }
+            break;
+        case TRACE_BLOCK :
+            printf("blocked, status %d\n", rec->arg);
+            break;
+        case TRACE_UNBLOCK :
+            printf("pid %d made ready by %d\n", rec->pid, rec->otherPid);
+            break;
+        case TRACE_QUIT :
+            printf("quit, status %d\n", rec->arg);
+            break;
+        case TRACE_ZAP :
+            printf("pid %d zapped %d\n", rec->pid, rec->otherPid);
+            break;
+        default :
+            printf("unknown record\n");
+    }
+} /* printRecord */
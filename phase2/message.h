@@ -7,21 +7,105 @@
 #define SEND_BLOCK 11
 #define RECV_BLOCK 12
 
+// Direct handoff to the receiver on zero-slot mailboxes, needs our phase1
+#ifndef MBOX_HANDOFF
+#define MBOX_HANDOFF 0
+#endif
+
+// Free mailbox bitmap, 64 mailboxes per word, plus a summary bitmap with
+// one bit per word that has a free mailbox
+#define MBOXWORDS ((MAXMBOX + 63) / 64)
+#define MBOXSUMMARYWORDS ((MBOXWORDS + 63) / 64)
+
+// Largest message a mailbox may be created for; may be raised above the
+// MAX_MESSAGE of phase2.h
+#ifndef MBOX_MAX_MESSAGE
+#define MBOX_MAX_MESSAGE MAX_MESSAGE
+#endif
+
+// Message payloads come from one arena of SLAB_BYTES, carved into chunks
+// of the smallest size class that fits, and reused within their class.
+// By default every slot can hold a MAX_MESSAGE message at once.
+#ifndef SLAB_BYTES
+#define SLAB_BYTES (MAXSLOTS * ((MAX_MESSAGE + SLAB_ALIGN - 1) & \
+                               ~(SLAB_ALIGN - 1)))
+#endif
+// The last class also holds a largest message with its bufHeader
+#define SLAB_SIZES {8, 16, 32, 64, MAX_MESSAGE, MBOX_MAX_MESSAGE + SLAB_ALIGN}
+#define NUMSLABCLASSES 6
+#define SLAB_ALIGN 8
+#define BUF_MAGIC 0x4d42
+
+// Write the system call counters to SYSSTATS_FILE when start2 returns;
+// 0 to disable
+#ifndef SYSSTATS
+#define SYSSTATS 1
+#endif
+#define SYSSTATS_FILE "syscall.stats"
+
+// Most mailboxes one MboxReceiveAny may wait on
+#define MAXSELECT 10
+
+// Device mailboxes 0..6: clock, disks 0-1, terminals 0-3. Each has a ring
+// of DEVRING_SIZE statuses, a power of two, kept for waitDevice while no
+// process is waiting on the device
+#define NUMDEVICES 7
+#define CLOCK_MBOX 0
+#ifndef DEVRING_SIZE
+#define DEVRING_SIZE 64
+#endif
+
+typedef struct bufHeader bufHeader;
 typedef struct mailbox   mailbox;
 typedef struct mboxProc  mboxProc;
 typedef struct mailSlot  mailSlot;
 typedef struct mailbox  *mailboxPtr;
 typedef struct mailSlot *slotPtr;
 typedef struct mboxProc *mboxProcPtr;
+typedef struct selectNode selectNode;
+typedef struct selectNode *selectNodePtr;
+typedef struct devRing   devRing;
+typedef struct bcastSub  bcastSub;
+
+// Precedes each buffer from MboxAllocBuf, in the same slab chunk
+struct bufHeader {
+    short     magic;         // BUF_MAGIC while the buffer is allocated
+    short     slabClass;
+    int       size;          // size asked for
+};
 
 struct mboxProc {
-    short pid;
+    int pid;
     int status;
-    void * message;
+    void * message;  // buffer, or the void ** of MboxReceiveRef if isRef
     int msgSize;
+    int isRef;       // in MboxSendRef or MboxReceiveRef
     int mboxReleased;
     mboxProcPtr nextBlockSend;
+    mboxProcPtr prevBlockSend;
     mboxProcPtr nextBlockRecv;
+    mboxProcPtr prevBlockRecv;
+    int waitMbox;    // mailbox blocked on, -1 if none
+    int blockType;   // SEND_BLOCK or RECV_BLOCK while on waitMbox's list
+    int timerIndex;  // place in TimerHeap, -1 if no timeout pending
+    int deadline;    // USLOSS_Clock() time the timeout runs out
+    int timedOut;
+    int numSelect;   // selectNodes in use by MboxReceiveAny
+    int selectMbox;  // mailbox MboxReceiveAny got its msg from
+    int msgPriority; // priority of the msg it is sending
+    int waitKey;     // place on a priority mailbox's blocked list, low first
+    int sysCallPid;  // pid in dispatchSyscall, -1 once the call is timed
+    int sysCall;     // system call it is making
+    int sysCallStart;
+    systemArgs *sysArgs;
+};
+
+// One of the mailboxes an MboxReceiveAny caller waits on
+struct selectNode {
+    mboxProcPtr proc;
+    int       mboxID;
+    selectNodePtr next;      // next waiter in the mailbox's selectList
+    selectNodePtr prev;
 };
 
 struct mailbox {
@@ -30,18 +114,54 @@ struct mailbox {
     int       slotsUsed;
     int       slotSize;
     mboxProcPtr blockSendList;
+    mboxProcPtr blockSendTail;
     mboxProcPtr blockRecvList;
-    slotPtr   slotList;
+    mboxProcPtr blockRecvTail;
+    slotPtr   slotList;      // messages in order, oldest first
+    slotPtr   slotTail;
     int       status;
+    int       lastReceiver;  // pid of the last process to receive
+    selectNodePtr selectList;  // MboxReceiveAny callers, oldest first
+    selectNodePtr selectTail;
+    int       broadcast;     // BCAST_OVERWRITE or BCAST_BLOCK, 0 if not
+    int       nextSeq;       // seq of the next message published
+    bcastSub *subList;       // subscribers of a broadcast mailbox
+    int       numSubs;
+    int       priorityOrder; // slots and blocked lists in priority order
+    slotPtr   slotPrioTail[NUMMSGPRIOS];   // last slot of each priority
+};
+
+// Filled by the interrupt handler at tail and drained by waitDevice at
+// head; the indexes only grow, and are taken mod DEVRING_SIZE
+struct devRing {
+    int       status[DEVRING_SIZE];
+    unsigned int head;
+    unsigned int tail;
+    int       coalesced;     // clock statuses replaced before being taken
+    int       overflows;     // statuses dropped because the ring was full
+};
+
+// A subscriber of a broadcast mailbox, reading at its own cursor
+struct bcastSub {
+    int       mboxID;        // -1 if free
+    int       nextSeq;       // seq of the next message it gets
+    int       missed;        // messages overwritten before it read them
+    int       waiter;        // pid blocked in MboxReceiveSub, -1 if none
+    bcastSub *nextSub;       // next in the mailbox's subList, or FreeSubs
 };
 
 struct mailSlot {
     int       slotID;
     int       mboxID;
     int       status;
-    char      message[MAX_MESSAGE];
+    char     *message;       // payload, NULL for an empty message
     int       msgSize;
-    slotPtr   nextSlot;
+    int       slabClass;     // size class of message, -1 if none
+    int       isRef;         // message is a buffer from MboxAllocBuf
+    int       seq;           // broadcast only: order published
+    int       refs;          // broadcast only: subscribers yet to read it
+    int       priority;      // 0 most urgent, MSG_PRIO_DEFAULT if not given
+    slotPtr   nextSlot;      // next in the mailbox's list, or FreeSlots
 };
 
 struct psrBits {
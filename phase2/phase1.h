@@ -45,7 +45,10 @@ extern int   isZapped(void);
 extern int   getpid(void);
 extern void  dumpProcesses(void);
 extern int   blockMe(int block_status);
+extern int   blockMeOn(int block_status, int pid);
 extern int   unblockProc(int pid);
+extern int   unblockMany(int pids[], int n);
+extern int   unblockHandoff(int pid);
 extern int   readCurStart_time(void);
 extern void  timeSlice(void);
 extern void  dispatcher(void);
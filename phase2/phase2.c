@@ -11,6 +11,8 @@
 #include <phase1.h>
 #include <phase2.h>
 #include <usloss.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -25,19 +27,62 @@ void enableInterrupts();
 int check_io();
 void zeroMailbox(int mboxID);
 void zeroSlot(int slotID);
+void freeSlot(int slotID);
+void setMboxFree(int mboxID, int isFree);
+char *allocMessage(int size, int *slabClass);
+void freeMessage(char *message, int slabClass);
+char *allocBuf(int size);
+void freeBuf(char *buf);
+bufHeader *getBufHeader(void *buf);
+slotPtr initRefSlot(int slotIndex, int mboxID, void *buf, int msg_size);
+int copyToReceiver(mboxProcPtr receiver, void *msg_ptr, int msg_size);
+void moveSenderToSlot(mailboxPtr mbptr);
 void zeroMboxProc(int pid);
 int MboxRelease(int mailboxID);
 int MboxCondSend(int mailboxID, void *message, int messageSize);
 int MboxCondReceive(int mailboxID, void *message,int maxMessageSize);
+int condSendReal(int mbox_id, void *msg_ptr, int msg_size);
+int condReceiveReal(int mbox_id, void *msg_ptr, int msg_size);
 int waitDevice(int type, int unit, int *status);
 void nullsys(systemArgs *args);
 void clockHandler2(int dev, long unit);
 void diskHandler(int dev, long unit);
 void termHandler(int dev, long unit);
 void syscallHandler(int dev, void *unit);
+void mboxSendMany(systemArgs *args);
+void mboxReceiveMany(systemArgs *args);
+void syscallStatsCall(systemArgs *args);
+void ringEnterCall(systemArgs *args);
+void dispatchSyscall(systemArgs *args);
+void recordSyscall(int sysCall, int time, int failed);
+void printSyscallStats(FILE *file);
+void statsLine(FILE *file, char *format, ...);
+void writeSyscallStats(void);
 slotPtr initSlot(int slotIndex, int mboxID, void *msg_ptr, int msg_size);
 int getSlotIndex();
 int addSlotToList(slotPtr slotToAdd, mailboxPtr mbptr);
+int addSlotByPriority(slotPtr slotToAdd, mailboxPtr mbptr);
+void removeFirstSlot(mailboxPtr mbptr);
+int waitKey(mboxProcPtr proc, int isSender);
+void addToBlockSendList(mailboxPtr mbptr, mboxProcPtr proc);
+void addToBlockRecvList(mailboxPtr mbptr, mboxProcPtr proc);
+void removeFromBlockSendList(mailboxPtr mbptr, mboxProcPtr proc);
+void removeFromBlockRecvList(mailboxPtr mbptr, mboxProcPtr proc);
+int sendReal(int mbox_id, void *msg_ptr, int msg_size, int timeout,
+             int priority);
+int receiveReal(int mbox_id, void *msg_ptr, int msg_size, int timeout);
+void addTimer(mboxProcPtr proc, int timeout);
+void removeTimer(mboxProcPtr proc);
+void siftTimer(int i);
+void expireTimers();
+void claimSelector(mailboxPtr mbptr);
+void cancelSelect(mboxProcPtr proc);
+void postDeviceStatus(int deviceID, int status);
+void keepDeviceStatus(int deviceID, int status);
+int takeDeviceStatus(int deviceID, int *status);
+void trimBroadcast(mailboxPtr mbptr);
+void dropOldest(mailboxPtr mbptr);
+int releaseSubscribers(mailboxPtr mbptr, int pids[]);
 /* -------------------------- Globals ------------------------------------- */
 int debugflag2 = 0;
 
@@ -45,15 +90,51 @@ int debugflag2 = 0;
 mailbox MailBoxTable[MAXMBOX];
 mailSlot SlotTable[MAXSLOTS];
 
+// free slots, linked through nextSlot
+slotPtr FreeSlots = NULL;
+
+// bit i is set iff MailBoxTable[i] is EMPTY; MboxSummary tracks non-zero
+// words
+unsigned long long FreeMboxes[MBOXWORDS];
+unsigned long long MboxSummary[MBOXSUMMARYWORDS];
+
+// message payload arena, the bytes of it handed out so far, and the free
+// chunks of each size class, linked through their first bytes
+char SlabArena[SLAB_BYTES] __attribute__((aligned(SLAB_ALIGN)));
+int slabUsed = 0;
+int slabSizes[NUMSLABCLASSES] = SLAB_SIZES;
+char *SlabFree[NUMSLABCLASSES];
+
+// subscribers of broadcast mailboxes, and the free ones, linked through
+// nextSub
+bcastSub BcastSubs[MAXSUBSCRIBERS];
+bcastSub *FreeSubs = NULL;
+
 // Process table
 mboxProc MboxProcTable[MAXPROC];
 
+// processes blocked with a timeout, a min-heap on deadline
+mboxProcPtr TimerHeap[MAXPROC];
+int numTimers = 0;
+
+// the mailboxes each MboxReceiveAny caller is waiting on
+selectNode SelectNodes[MAXPROC][MAXSELECT];
+
 // System call vector
 void (*systemCallVec[MAXSYSCALLS])(systemArgs *args);
 
+// what syscallHandler has counted for each system call
+syscallStats SyscallStats[MAXSYSCALLS];
+
 // Counter used by clock
 int clockCounter = 0;
 
+// device statuses that came while no process was in waitDevice
+devRing DeviceRings[NUMDEVICES];
+
+// nonzero to switch straight to the receiver on a zero-slot MboxSend
+int mboxHandoff = MBOX_HANDOFF;
+
 /* -------------------------- Functions ----------------------------------- */
 
 /* ------------------------------------------------------------------------
@@ -82,10 +163,10 @@ int start1(char *arg) {
         MboxCreate(0,0);
     }
 
-    // initialize slot array
-    for (int i = 0; i < MAXSLOTS; i++) {
+    // initialize slot array, with the free list in index order
+    for (int i = MAXSLOTS - 1; i >= 0; i--) {
         SlotTable[i].slotID = i;
-        zeroSlot(i);
+        freeSlot(i);
     }
 
     // initialize process table
@@ -93,6 +174,13 @@ int start1(char *arg) {
         zeroMboxProc(i);
     }
 
+    // initialize subscribers, with the free list in index order
+    for (int i = MAXSUBSCRIBERS - 1; i >= 0; i--) {
+        BcastSubs[i].mboxID = -1;
+        BcastSubs[i].nextSub = FreeSubs;
+        FreeSubs = &BcastSubs[i];
+    }
+
     // Initialize USLOSS_IntVec and system call handlers,
     USLOSS_IntVec[USLOSS_CLOCK_INT] = (void*)clockHandler2;
     USLOSS_IntVec[USLOSS_DISK_INT] = (void*)diskHandler;
@@ -102,6 +190,10 @@ int start1(char *arg) {
     for (int i = 0; i < MAXSYSCALLS; i++) {
         systemCallVec[i] = nullsys;
     }
+    systemCallVec[SYS_MBOXSENDMANY] = mboxSendMany;
+    systemCallVec[SYS_MBOXRECEIVEMANY] = mboxReceiveMany;
+    systemCallVec[SYS_SYSCALLSTATS] = syscallStatsCall;
+    systemCallVec[SYS_RINGENTER] = ringEnterCall;
 
     enableInterrupts();
 
@@ -113,6 +205,10 @@ int start1(char *arg) {
         USLOSS_Console("start2(): join returned something other than ");
         USLOSS_Console("start2's pid\n");
     }
+    if (DEBUG2 && debugflag2)
+        dumpSyscallStats();
+    if (SYSSTATS)
+        writeSyscallStats();
 
     return 0;
 } /* start1 */
@@ -136,21 +232,26 @@ int MboxCreate(int slots, int slot_size) {
         enableInterrupts();
         return -1;
     }
-    if (slot_size < 0 || slot_size > MAX_MESSAGE) {
+    if (slot_size < 0 || slot_size > MBOX_MAX_MESSAGE) {
         enableInterrupts();
         return -1;
     }
 
-    // setup next available mailbox from the mailbox table
-    for (int i = 0; i < MAXMBOX; i++) {
-        if (MailBoxTable[i].status == EMPTY) {
-            MailBoxTable[i].numSlots = slots;
-            MailBoxTable[i].slotsUsed = 0;
-            MailBoxTable[i].slotSize = slot_size;
-            MailBoxTable[i].status = USED;
-            enableInterrupts();
-            return i;
+    // setup the lowest numbered free mailbox, found from the bitmaps
+    for (int w = 0; w < MBOXSUMMARYWORDS; w++) {
+        if (MboxSummary[w] == 0) {
+            continue;
         }
+        int word = w * 64 + __builtin_ctzll(MboxSummary[w]);
+        int i = word * 64 + __builtin_ctzll(FreeMboxes[word]);
+
+        MailBoxTable[i].numSlots = slots;
+        MailBoxTable[i].slotsUsed = 0;
+        MailBoxTable[i].slotSize = slot_size;
+        MailBoxTable[i].status = USED;
+        setMboxFree(i, 0);
+        enableInterrupts();
+        return i;
     }
     enableInterrupts();
     return -1;
@@ -167,10 +268,69 @@ int MboxCreate(int slots, int slot_size) {
    ----------------------------------------------------------------------- */
 int MboxSend(int mbox_id, void *msg_ptr, int msg_size) {
     check_kernel_mode("MboxSend");
+    return sendReal(mbox_id, msg_ptr, msg_size, 0, MSG_PRIO_DEFAULT);
+} /* MboxSend */
+
+
+/* ------------------------------------------------------------------------
+   Name - MboxSendPriority
+   Purpose - Like MboxSend, but with a priority. In a mailbox from
+             MboxCreatePriority the message goes ahead of any less urgent
+             ones, and, if the sender blocks, so does the sender.
+   Parameters - mailbox id, pointer to data of msg, # of bytes in msg,
+                priority, 0 the most urgent.
+   Returns - zero if successful, -1 if invalid args, -3 if zapped or the
+             mailbox was released.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxSendPriority(int mbox_id, void *msg_ptr, int msg_size,
+                     int priority) {
+    check_kernel_mode("MboxSendPriority");
+    if (priority < 0 || priority >= NUMMSGPRIOS) {
+        return -1;
+    }
+    return sendReal(mbox_id, msg_ptr, msg_size, 0, priority);
+} /* MboxSendPriority */
+
+
+/* ------------------------------------------------------------------------
+   Name - MboxSendTimed
+   Purpose - Like MboxSend, but gives up if the message could not be sent
+             within timeout microseconds. The timeout is checked by the
+             clock interrupt handler, so it may run up to one clock
+             interrupt late.
+   Parameters - mailbox id, pointer to data of msg, # of bytes in msg,
+                timeout in microseconds.
+   Returns - zero if successful, -1 if invalid args, -2 if the timeout
+             ran out, -3 if zapped or the mailbox was released.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxSendTimed(int mbox_id, void *msg_ptr, int msg_size, int timeout) {
+    check_kernel_mode("MboxSendTimed");
+    if (timeout <= 0) {
+        return -1;
+    }
+    return sendReal(mbox_id, msg_ptr, msg_size, timeout, MSG_PRIO_DEFAULT);
+} /* MboxSendTimed */
+
+
+/* ------------------------------------------------------------------------
+   Name - sendReal
+   Purpose - Does the work of MboxSend, MboxSendTimed and MboxSendPriority.
+   Parameters - mailbox id, pointer to data of msg, # of bytes in msg,
+                timeout in microseconds, 0 to wait for as long as it takes,
+                priority of the msg.
+   Returns - zero if successful, -1 if invalid args, -2 if the timeout
+             ran out, -3 if zapped or the mailbox was released.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int sendReal(int mbox_id, void *msg_ptr, int msg_size, int timeout,
+             int priority) {
     disableInterrupts();
 
     // error checking for parameters and empty mailbox
-    if (MailBoxTable[mbox_id].status == EMPTY) {
+    if (MailBoxTable[mbox_id].status == EMPTY ||
+            MailBoxTable[mbox_id].broadcast) {
         enableInterrupts();
         return -1;
     }
@@ -192,20 +352,27 @@ int MboxSend(int mbox_id, void *msg_ptr, int msg_size) {
     MboxProcTable[pid % MAXPROC].status = ACTIVE;
     MboxProcTable[pid % MAXPROC].message = msg_ptr;
     MboxProcTable[pid % MAXPROC].msgSize = msg_size;
+    MboxProcTable[pid % MAXPROC].isRef = 0;
+    MboxProcTable[pid % MAXPROC].msgPriority = priority;
+    claimSelector(mbptr);
 
     // Block if no available slots and no process on recv list. 
     // Add to next blockSendList
     if (mbptr->numSlots <= mbptr->slotsUsed && mbptr->blockRecvList == NULL) {
-        if (mbptr->blockSendList == NULL) {
-            mbptr->blockSendList = &MboxProcTable[pid % MAXPROC];
-        } else {
-            mboxProcPtr temp = mbptr->blockSendList;
-            while (temp->nextBlockSend != NULL) {
-                temp = temp->nextBlockSend;
-            }
-            temp->nextBlockSend = &MboxProcTable[pid % MAXPROC];
+        addToBlockSendList(mbptr, &MboxProcTable[pid % MAXPROC]);
+        if (timeout > 0) {
+            addTimer(&MboxProcTable[pid % MAXPROC], timeout);
         }
+#ifdef OWN_PHASE1
+        // lend our priority to the receiver most likely to make room
+        blockMeOn(SEND_BLOCK, mbptr->lastReceiver);
+#else
         blockMe(SEND_BLOCK);
+#endif
+        if (MboxProcTable[pid % MAXPROC].timedOut) {
+            enableInterrupts();
+            return -2;
+        }
         if(MboxProcTable[pid % MAXPROC].mboxReleased){
           enableInterrupts();  
           return -3;
@@ -216,42 +383,57 @@ int MboxSend(int mbox_id, void *msg_ptr, int msg_size) {
     // check if process on recieve block list
     if (mbptr->blockRecvList != NULL) {
 
-        // message size bigger than receive buffer size
-        if (msg_size > mbptr->blockRecvList->msgSize) {
+        // message size bigger than receive buffer size, or no buffer for
+        // a receiver in MboxReceiveRef
+        if (msg_size > mbptr->blockRecvList->msgSize ||
+                copyToReceiver(mbptr->blockRecvList, msg_ptr, msg_size) < 0) {
             mbptr->blockRecvList->status = FAILED;
             int pid = mbptr->blockRecvList->pid;
-            mbptr->blockRecvList = mbptr->blockRecvList->nextBlockRecv;
+            removeFromBlockRecvList(mbptr, mbptr->blockRecvList);
             unblockProc(pid);
             enableInterrupts();
             return -1;
         }
-       
-        // copy the message to the receive process buffer
-        memcpy(mbptr->blockRecvList->message, msg_ptr, msg_size);
         mbptr->blockRecvList->msgSize = msg_size;
         int recvPid = mbptr->blockRecvList->pid;
-        mbptr->blockRecvList = mbptr->blockRecvList->nextBlockRecv;
+        removeFromBlockRecvList(mbptr, mbptr->blockRecvList);
+#ifdef OWN_PHASE1
+        // rendezvous: let the receiver run now rather than after a dispatch
+        if (mbptr->numSlots == 0 && mboxHandoff) {
+            unblockHandoff(recvPid);
+        } else {
+            unblockProc(recvPid);
+        }
+#else
         unblockProc(recvPid);
+#endif
         enableInterrupts();
         return isZapped() ? -3 : 0;
     }
     
-    // find an empty slot in SlotTable
+    // find an empty slot in SlotTable, with room for the message
     int slot = getSlotIndex();
+    slotPtr slotToAdd = NULL;
+    if (slot != -2) {
+        slotToAdd = initSlot(slot, mbptr->mboxID, msg_ptr, msg_size);
+    }
     if (slot == -2) {
         USLOSS_Console("MboxSend(): No slots in system. Halting...\n");
         USLOSS_Halt(1);
     }
-
-    // initialize slot
-    slotPtr slotToAdd = initSlot(slot, mbptr->mboxID, msg_ptr, msg_size);
+    if (slotToAdd == NULL) {
+        USLOSS_Console("MboxSend(): No room for the message in the slab "
+                       "arena. Halting...\n");
+        USLOSS_Halt(1);
+    }
+    slotToAdd->priority = priority;
 
     // place found slot on slotList
     addSlotToList(slotToAdd, mbptr);
 
     enableInterrupts();
     return isZapped() ? -3 : 0;
-} /* MboxSend */
+} /* sendReal */
 
 
 /* ------------------------------------------------------------------------
@@ -265,10 +447,45 @@ int MboxSend(int mbox_id, void *msg_ptr, int msg_size) {
    ----------------------------------------------------------------------- */
 int MboxReceive(int mbox_id, void *msg_ptr, int msg_size) {
     check_kernel_mode("MboxReceive");
+    return receiveReal(mbox_id, msg_ptr, msg_size, 0);
+} /* MboxReceive */
+
+
+/* ------------------------------------------------------------------------
+   Name - MboxReceiveTimed
+   Purpose - Like MboxReceive, but gives up if no message arrived within
+             timeout microseconds, give or take one clock interrupt.
+   Parameters - mailbox id, pointer to put data of msg, max # of bytes that
+                can be received, timeout in microseconds.
+   Returns - actual size of msg if successful, -1 if invalid args, -2 if
+             the timeout ran out, -3 if zapped or the mailbox was released.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxReceiveTimed(int mbox_id, void *msg_ptr, int msg_size, int timeout) {
+    check_kernel_mode("MboxReceiveTimed");
+    if (timeout <= 0) {
+        return -1;
+    }
+    return receiveReal(mbox_id, msg_ptr, msg_size, timeout);
+} /* MboxReceiveTimed */
+
+
+/* ------------------------------------------------------------------------
+   Name - receiveReal
+   Purpose - Does the work of MboxReceive and MboxReceiveTimed.
+   Parameters - mailbox id, pointer to put data of msg, max # of bytes that
+                can be received, timeout in microseconds, 0 to wait for
+                as long as it takes.
+   Returns - actual size of msg if successful, -1 if invalid args, -2 if
+             the timeout ran out, -3 if zapped or the mailbox was released.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int receiveReal(int mbox_id, void *msg_ptr, int msg_size, int timeout) {
     disableInterrupts();
 
     // error checking for parameters
-    if (MailBoxTable[mbox_id].status == EMPTY) {
+    if (MailBoxTable[mbox_id].status == EMPTY ||
+            MailBoxTable[mbox_id].broadcast) {
         enableInterrupts();
         return -1;
     }
@@ -286,12 +503,14 @@ int MboxReceive(int mbox_id, void *msg_ptr, int msg_size) {
     MboxProcTable[pid % MAXPROC].status = ACTIVE;
     MboxProcTable[pid % MAXPROC].message = msg_ptr;
     MboxProcTable[pid % MAXPROC].msgSize = msg_size;
+    MboxProcTable[pid % MAXPROC].isRef = 0;
+    mbptr->lastReceiver = pid;
 
     // mailbox is has zero slots and there is a process on send list
     if (mbptr->numSlots == 0 && mbptr->blockSendList != NULL) {
         mboxProcPtr sender = mbptr->blockSendList;
         memcpy(msg_ptr, sender->message, sender->msgSize);
-        mbptr->blockSendList = mbptr->blockSendList->nextBlockSend;
+        removeFromBlockSendList(mbptr, mbptr->blockSendList);
         unblockProc(sender->pid);
         return sender->msgSize;
     }
@@ -302,18 +521,19 @@ int MboxReceive(int mbox_id, void *msg_ptr, int msg_size) {
     if (slotptr == NULL) {  
 
         // receive process adds itself to receive list
-        if (mbptr->blockRecvList == NULL) {
-            mbptr->blockRecvList = &MboxProcTable[pid % MAXPROC];
-        } else {
-            mboxProcPtr temp = mbptr->blockRecvList;
-            while (temp->nextBlockRecv != NULL) {
-                temp = temp->nextBlockRecv;
-            }
-            temp->nextBlockRecv = &MboxProcTable[pid % MAXPROC];
+        addToBlockRecvList(mbptr, &MboxProcTable[pid % MAXPROC]);
+        if (timeout > 0) {
+            addTimer(&MboxProcTable[pid % MAXPROC], timeout);
         }
 
         // block until sender arrives at mailbox
         blockMe(RECV_BLOCK);
+
+        // no sender came in time
+        if (MboxProcTable[pid % MAXPROC].timedOut) {
+            enableInterrupts();
+            return -2;
+        }
         
         // process was zapped or mailbox was released
         if(MboxProcTable[pid % MAXPROC].mboxReleased || isZapped()){
@@ -340,34 +560,19 @@ int MboxReceive(int mbox_id, void *msg_ptr, int msg_size) {
 
         // copy message into receive messsage buffer
         memcpy(msg_ptr, slotptr->message, slotptr->msgSize);
-        mbptr->slotList = slotptr->nextSlot;
+        removeFirstSlot(mbptr);
         int msgSize = slotptr->msgSize;
-        zeroSlot(slotptr->slotID);
+        freeSlot(slotptr->slotID);
         mbptr->slotsUsed--;
 
         // there is a message on the send list waiting for a slot
         if (mbptr->blockSendList != NULL) {
-
-            // get slot from slot array
-            int slotIndex = getSlotIndex();
-
-            // initialize slot with message and message size
-            slotPtr slotToAdd = initSlot(slotIndex, mbptr->mboxID,
-                    mbptr->blockSendList->message, 
-                    mbptr->blockSendList->msgSize);
-
-            // add slot to the slot list
-            addSlotToList(slotToAdd, mbptr);
-        
-            // wake up a process blocked on send list
-            int pid = mbptr->blockSendList->pid;
-            mbptr->blockSendList = mbptr->blockSendList->nextBlockSend;
-            unblockProc(pid);
+            moveSenderToSlot(mbptr);
         }
         enableInterrupts();
         return isZapped() ? -3 : msgSize;
     }
-} /* MboxReceive */
+} /* receiveReal */
 
 /* ------------------------------------------------------------------------
    Name - MboxRelease
@@ -392,8 +597,19 @@ int MboxRelease(int mailboxID) {
     }
     mailboxPtr mbptr = &MailBoxTable[mailboxID];
 
+    // return any unreceived messages' slots to the free list
+    while (mbptr->slotList != NULL) {
+        slotPtr slotptr = mbptr->slotList;
+        removeFirstSlot(mbptr);
+        freeSlot(slotptr->slotID);
+    }
+
+    int pids[MAXPROC];  // blocked processes to wake
+    int numPids = releaseSubscribers(mbptr, pids);
+
     // no processes on send and receive block lists
-    if (mbptr->blockSendList == NULL && mbptr->blockRecvList == NULL) {
+    if (numPids == 0 && mbptr->blockSendList == NULL &&
+            mbptr->blockRecvList == NULL && mbptr->selectList == NULL) {
         zeroMailbox(mailboxID);
         enableInterrupts();
         return isZapped() ? -3 : 0;
@@ -403,18 +619,31 @@ int MboxRelease(int mailboxID) {
         // mark all processes on block send and recveive list as being released
         while (mbptr->blockSendList != NULL) {
             mbptr->blockSendList->mboxReleased = 1;
-            int pid = mbptr->blockSendList->pid;
-            mbptr->blockSendList = mbptr->blockSendList->nextBlockSend;
-            unblockProc(pid);
-            disableInterrupts();
+            pids[numPids++] = mbptr->blockSendList->pid;
+            removeFromBlockSendList(mbptr, mbptr->blockSendList);
         }
         while (mbptr->blockRecvList != NULL) {
             mbptr->blockRecvList->mboxReleased = 1;
-            int pid = mbptr->blockRecvList->pid;
-            mbptr->blockRecvList = mbptr->blockRecvList->nextBlockRecv;
-            unblockProc(pid);
+            pids[numPids++] = mbptr->blockRecvList->pid;
+            removeFromBlockRecvList(mbptr, mbptr->blockRecvList);
+        }
+        while (mbptr->selectList != NULL) {
+            mboxProcPtr proc = mbptr->selectList->proc;
+            proc->mboxReleased = 1;
+            pids[numPids++] = proc->pid;
+            cancelSelect(proc);
+        }
+
+        // wake them all, with a single reschedule if unblockMany is there
+#ifdef OWN_PHASE1
+        unblockMany(pids, numPids);
+        disableInterrupts();
+#else
+        for (int i = 0; i < numPids; i++) {
+            unblockProc(pids[i]);
             disableInterrupts();
         }
+#endif
     }
     zeroMailbox(mailboxID); // zero members of the mailbox struct
     enableInterrupts();
@@ -431,6 +660,22 @@ int MboxRelease(int mailboxID) {
    ----------------------------------------------------------------------- */
 int MboxCondSend(int mbox_id, void *msg_ptr, int msg_size){
     check_kernel_mode("MboxCondSend");
+    int result = condSendReal(mbox_id, msg_ptr, msg_size);
+    return result == 0 && isZapped() ? -3 : result;
+} /* MboxCondSend */
+
+
+/* ------------------------------------------------------------------------
+   Name - condSendReal
+   Purpose - Does the work of MboxCondSend, without the check for being
+             zapped, so MboxSendMany can count a msg sent by a zapped
+             process.
+   Parameters - mailbox id, pointer to data of msg, # of bytes in msg.
+   Returns - zero if successful, -1 if invalid args, -2 if no slot
+             available.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int condSendReal(int mbox_id, void *msg_ptr, int msg_size) {
     disableInterrupts();
 
     // error check parameters
@@ -441,7 +686,8 @@ int MboxCondSend(int mbox_id, void *msg_ptr, int msg_size){
 
     mailboxPtr mbptr = &MailBoxTable[mbox_id];
 
-    if (mbptr->numSlots != 0 && msg_size > mbptr->slotSize) {
+    if (mbptr->broadcast ||
+            (mbptr->numSlots != 0 && msg_size > mbptr->slotSize)) {
         enableInterrupts();
         return -1;
     }
@@ -452,6 +698,15 @@ int MboxCondSend(int mbox_id, void *msg_ptr, int msg_size){
     MboxProcTable[pid % MAXPROC].status = ACTIVE;
     MboxProcTable[pid % MAXPROC].message = msg_ptr;
     MboxProcTable[pid % MAXPROC].msgSize = msg_size;
+    MboxProcTable[pid % MAXPROC].isRef = 0;
+
+    // a selector the msg does not fit stays waiting on all its mailboxes
+    if (mbptr->blockRecvList == NULL && mbptr->selectList != NULL &&
+            msg_size > mbptr->selectList->proc->msgSize) {
+        enableInterrupts();
+        return -1;
+    }
+    claimSelector(mbptr);
 
     // No empty slots in mailbox or no slots in system
     if (mbptr->numSlots != 0 && mbptr->numSlots == mbptr->slotsUsed) {
@@ -471,30 +726,33 @@ int MboxCondSend(int mbox_id, void *msg_ptr, int msg_size){
         }
 
         // copy message into blocked receive process message buffer
-        memcpy(mbptr->blockRecvList->message, msg_ptr, msg_size);
+        if (copyToReceiver(mbptr->blockRecvList, msg_ptr, msg_size) < 0) {
+            return -2;
+        }
         mbptr->blockRecvList->msgSize = msg_size;
         int recvPid = mbptr->blockRecvList->pid;
-        mbptr->blockRecvList = mbptr->blockRecvList->nextBlockRecv;
+        removeFromBlockRecvList(mbptr, mbptr->blockRecvList);
         unblockProc(recvPid);
         enableInterrupts();
-        return isZapped() ? -3 : 0;
+        return 0;
     }
     
-    // find an empty slot in SlotTable
+    // find an empty slot in SlotTable, with room for the message
     int slot = getSlotIndex();
     if (slot == -2) {
         return -2;
     }
-
-    // initialize slot
     slotPtr slotToAdd = initSlot(slot, mbptr->mboxID, msg_ptr, msg_size);
+    if (slotToAdd == NULL) {
+        return -2;
+    }
 
     // place found slot on slotList
     addSlotToList(slotToAdd, mbptr);
     
     enableInterrupts();
-    return isZapped() ? -3 : 0;
-}
+    return 0;
+} /* condSendReal */
 
 /* ------------------------------------------------------------------------
    Name - MboxCondReceive
@@ -507,10 +765,28 @@ int MboxCondSend(int mbox_id, void *msg_ptr, int msg_size){
    ----------------------------------------------------------------------- */
 int MboxCondReceive(int mbox_id, void *msg_ptr,int msg_size){
     check_kernel_mode("MboxCondReceive");
+    int result = condReceiveReal(mbox_id, msg_ptr, msg_size);
+    return result >= 0 && isZapped() ? -3 : result;
+} /* MboxCondReceive */
+
+
+/* ------------------------------------------------------------------------
+   Name - condReceiveReal
+   Purpose - Does the work of MboxCondReceive, without the check for being
+             zapped, so MboxReceiveMany keeps the size of a msg taken by a
+             zapped process.
+   Parameters - mailbox id, pointer to put data of msg, max # of bytes that
+                can be received.
+   Returns - actual size of msg if successful, -1 if invalid args, -2 if
+             no msg available.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int condReceiveReal(int mbox_id, void *msg_ptr, int msg_size) {
     disableInterrupts();
 
     // error checking for parameters
-    if (MailBoxTable[mbox_id].status == EMPTY) {
+    if (MailBoxTable[mbox_id].status == EMPTY ||
+            MailBoxTable[mbox_id].broadcast) {
         enableInterrupts();
         return -1;
     }
@@ -528,12 +804,14 @@ int MboxCondReceive(int mbox_id, void *msg_ptr,int msg_size){
     MboxProcTable[pid % MAXPROC].status = ACTIVE;
     MboxProcTable[pid % MAXPROC].message = msg_ptr;
     MboxProcTable[pid % MAXPROC].msgSize = msg_size;
+    MboxProcTable[pid % MAXPROC].isRef = 0;
+    mbptr->lastReceiver = pid;
 
     // mailbox has zero slots and there is a process on send list
     if (mbptr->numSlots == 0 && mbptr->blockSendList != NULL) {
         mboxProcPtr sender = mbptr->blockSendList;
         memcpy(msg_ptr, sender->message, sender->msgSize);
-        mbptr->blockSendList = mbptr->blockSendList->nextBlockSend;
+        removeFromBlockSendList(mbptr, mbptr->blockSendList);
         unblockProc(sender->pid);
         return sender->msgSize;
     }
@@ -555,292 +833,1914 @@ int MboxCondReceive(int mbox_id, void *msg_ptr,int msg_size){
 
         // copy message into receive messsage buffer
         memcpy(msg_ptr, slotptr->message, slotptr->msgSize);
-        mbptr->slotList = slotptr->nextSlot;
+        removeFirstSlot(mbptr);
         int msgSize = slotptr->msgSize;
-        zeroSlot(slotptr->slotID);
+        freeSlot(slotptr->slotID);
         mbptr->slotsUsed--;
 
         // there is a message on the send list waiting for a slot
         if (mbptr->blockSendList != NULL) {
-
-            // get slot from slot array
-            int slotIndex = getSlotIndex();
-
-            // initialize slot with message and message size
-            slotPtr slotToAdd = initSlot(slotIndex, mbptr->mboxID,
-                    mbptr->blockSendList->message, 
-                    mbptr->blockSendList->msgSize);
-
-            // add slot to the slot list
-            addSlotToList(slotToAdd, mbptr);
-        
-            // wake up a process blocked on send list
-            int pid = mbptr->blockSendList->pid;
-            mbptr->blockSendList = mbptr->blockSendList->nextBlockSend;
-            unblockProc(pid);
+            moveSenderToSlot(mbptr);
         }
         enableInterrupts();
-        return isZapped() ? -3 : msgSize;
+        return msgSize;
     }
-}
+} /* condReceiveReal */
 
 /* ------------------------------------------------------------------------
-   Name - waitDevice
-   Purpose - Block the process on the device until the device sends msg.
-   Parameters - type, unit, status
-   Returns - -1 if zapped, 0 otherwise
+   Name - MboxSendMany
+   Purpose - Sends a batch of messages to the indicated mailbox in one
+             call. Blocks like MboxSend until the first message is sent,
+             then sends the rest in order like MboxCondSend, stopping at
+             the first that cannot be sent at once.
+   Parameters - mailbox id, the messages, their sizes, # of messages.
+   Returns - the number of messages sent, -1 if invalid args or the first
+             message is invalid, -3 if zapped or the mailbox was released
+             before the first message was sent.
    Side Effects - none.
    ----------------------------------------------------------------------- */
-int waitDevice(int type, int unit, int *status){
-    check_kernel_mode("waitDevice");
-    disableInterrupts();
+int MboxSendMany(int mbox_id, void *msgs[], int sizes[], int count) {
+    check_kernel_mode("MboxSendMany");
 
-    int returnCode;               // -1 if process was zapped, 0 otherwise
-    int deviceID;                 // the index of the i/o mailbox
-    int clockID = 0;              // index of the clock i/o mailbox
-    int diskID[] = {1, 2};        // indexes of the disk i/o mailboxes
-    int termID[] = {3, 4, 5, 6};  // indexes of the terminal i/o mailboxes
+    if (count < 0 || (count > 0 && (msgs == NULL || sizes == NULL))) {
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
 
-    // determine the index of the i/o mailbox for the given device type and unit
-    switch (type) {
-        case USLOSS_CLOCK_INT:
-            deviceID = clockID;
-            break;
-        case USLOSS_DISK_INT:
-            if (unit >  1 || unit < 0) {
-                USLOSS_Console("waitDevice(): invalid unit  Halting\n");
-		USLOSS_Halt(1);
-            }
-            deviceID = diskID[unit];
-            break;
-        case USLOSS_TERM_INT:
-            if (unit >  3 || unit < 0) {
-                USLOSS_Console("waitDevice(): invalid unit  Halting...\n");
-		USLOSS_Halt(1);
-            }
-            deviceID = termID[unit];
-            break;
-        default:
-            USLOSS_Console("waitDevice(): invalid device or unit type  Halting...\n");
-	    USLOSS_Halt(1);
+    int result = MboxSend(mbox_id, msgs[0], sizes[0]);
+    if (result < 0) {
+        return result;
     }
 
-    // wait for status of device
-    returnCode = MboxReceive(deviceID, status, sizeof(int));
-    return returnCode == -3 ? -1 : 0;
-}
+    // a zapped process stops, but counts what it has sent
+    int sent = 1;
+    while (sent < count && !isZapped() &&
+            condSendReal(mbox_id, msgs[sent], sizes[sent]) == 0) {
+        sent++;
+    }
+    return sent;
+} /* MboxSendMany */
 
-/* 
- *check_kernel_mode
- */
-void check_kernel_mode(char * processName) {
-    if((USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0) {
-        USLOSS_Console("check_kernal_mode(): called while in user mode, by"
-                " process %s. Halting...\n", processName);
-        USLOSS_Halt(1);
-    } 
-}
+/* ------------------------------------------------------------------------
+   Name - MboxReceiveMany
+   Purpose - Receives a batch of messages from the indicated mailbox in
+             one call. Blocks like MboxReceive until the first message
+             arrives, then takes the messages already waiting like
+             MboxCondReceive, stopping when there are none or the next
+             one does not fit.
+   Parameters - mailbox id, buffers for the messages, the size of each
+                buffer, # of buffers. The size of each message received
+                is put back in sizes.
+   Returns - the number of messages received, -1 if invalid args or the
+             first message does not fit, -3 if zapped or the mailbox was
+             released before the first message arrived.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxReceiveMany(int mbox_id, void *msgs[], int sizes[], int count) {
+    check_kernel_mode("MboxReceiveMany");
 
-/*
- *enable_interrupts 
- */
-void enableInterrupts() {
-    USLOSS_PsrSet(USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT);
-}
+    if (count < 0 || (count > 0 && (msgs == NULL || sizes == NULL))) {
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
 
-/*
- * Disables the interrupts.
- */
-void disableInterrupts() {
-    USLOSS_PsrSet( USLOSS_PsrGet() & ~USLOSS_PSR_CURRENT_INT );
-} /* disableInterrupts */
+    int result = MboxReceive(mbox_id, msgs[0], sizes[0]);
+    if (result < 0) {
+        return result;
+    }
+    sizes[0] = result;
 
-/*
- * checks if any procs are blocked on io mailbox
- */
-int check_io() {
-    for (int i = 0; i < 7; i++) { 
-        if (MailBoxTable[i].blockRecvList != NULL) {
-            return 1;
+    // a zapped process stops, but keeps what it has received
+    int received = 1;
+    while (received < count && !isZapped()) {
+        result = condReceiveReal(mbox_id, msgs[received], sizes[received]);
+        if (result < 0) {
+            break;
         }
+        sizes[received++] = result;
     }
-    return 0;
-}
-
-/*
- *Zeros all elements of the mailbox for that id
- */
-void zeroMailbox(int mboxID) {
-    MailBoxTable[mboxID].numSlots = -1;
-    MailBoxTable[mboxID].slotsUsed = -1;
-    MailBoxTable[mboxID].slotSize = -1;
-    MailBoxTable[mboxID].blockSendList = NULL;
-    MailBoxTable[mboxID].blockRecvList = NULL;
-    MailBoxTable[mboxID].slotList = NULL;
-    MailBoxTable[mboxID].status = EMPTY;
-}
-
-/*
- *Zeros all elements of the slot for that id
- */
-void zeroSlot(int slotID) {
-    SlotTable[slotID].mboxID = -1;
-    SlotTable[slotID].status = EMPTY;
-    SlotTable[slotID].nextSlot = NULL;
-}
-
-/*
- *Zeros all elements of the process for that id
- */
-void zeroMboxProc(int pid) {
-   MboxProcTable[pid % MAXPROC].pid = -1; 
-   MboxProcTable[pid % MAXPROC].status = EMPTY; 
-   MboxProcTable[pid % MAXPROC].message = NULL; 
-   MboxProcTable[pid % MAXPROC].msgSize = -1; 
-   MboxProcTable[pid % MAXPROC].mboxReleased = 0; 
-   MboxProcTable[pid % MAXPROC].nextBlockSend = NULL; 
-   MboxProcTable[pid % MAXPROC].nextBlockRecv = NULL; 
-}
-
-/* an error method to handle invalid syscalls */
-void nullsys(systemArgs *args)
-{
-    USLOSS_Console("nullsys(): Invalid syscall %d. Halting...\n", args->number);
-    USLOSS_Halt(1);
-} /* nullsys */
+    return received;
+} /* MboxReceiveMany */
 
 /* ------------------------------------------------------------------------
-   Name - clockHandler2
-   Purpose - called when interrupt vector is activated for this device
-   Parameters - device, unit
-   Returns - void
-   Side Effects - increases clock counted by 1.
+   Name - MboxReceiveAny
+   Purpose - Get a msg from whichever of several mailboxes has one first.
+             Block the receiving process if none of them has a msg. While
+             blocked, the process waits on each mailbox's select list, and
+             the first sender to any of them hands it the msg.
+   Parameters - array of mailbox ids, # of ids (at most MAXSELECT),
+                pointer to put data of msg, max # of bytes that can be
+                received, where to put the id of the mailbox received from.
+   Returns - actual size of msg if successful, -1 if invalid args, -3 if
+             zapped or one of the mailboxes was released.
+   Side Effects - none.
    ----------------------------------------------------------------------- */
-void clockHandler2(int dev, long unit) {
-    check_kernel_mode("clockHandler2");
+int MboxReceiveAny(int mbox_ids[], int count, void *msg_ptr, int msg_size,
+                   int *which) {
+    check_kernel_mode("MboxReceiveAny");
     disableInterrupts();
 
-    if (dev != USLOSS_CLOCK_INT || unit != 0) {
-        USLOSS_Console("clockHandler2(): wrong device or unit\n");
-        USLOSS_Halt(1);
+    // error checking for parameters
+    if (count < 1 || count > MAXSELECT || msg_size < 0 || which == NULL) {
+        enableInterrupts();
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (mbox_ids[i] < 0 || mbox_ids[i] >= MAXMBOX ||
+                MailBoxTable[mbox_ids[i]].status == EMPTY ||
+                MailBoxTable[mbox_ids[i]].broadcast) {
+            enableInterrupts();
+            return -1;
+        }
     }
-    int status;
 
-    clockCounter++;
-    if (clockCounter >= 5) {
-        USLOSS_DeviceInput(USLOSS_CLOCK_INT, 0, &status);
-        MboxCondSend(0, &status, sizeof(int));
-        clockCounter = 0;
+    // take a msg from the first mailbox that has one
+    for (int i = 0; i < count; i++) {
+        mailboxPtr mbptr = &MailBoxTable[mbox_ids[i]];
+
+        if (mbptr->slotList != NULL ||
+                (mbptr->numSlots == 0 && mbptr->blockSendList != NULL)) {
+            *which = mbox_ids[i];
+            int result = MboxCondReceive(mbox_ids[i], msg_ptr, msg_size);
+            enableInterrupts();
+            return result;
+        }
+    }
+
+    // Add process to Process Table
+    int pid = getpid();
+    mboxProcPtr proc = &MboxProcTable[pid % MAXPROC];
+    proc->pid = pid;
+    proc->status = ACTIVE;
+    proc->message = msg_ptr;
+    proc->msgSize = msg_size;
+    proc->isRef = 0;
+    proc->mboxReleased = 0;
+    proc->selectMbox = -1;
+
+    // wait at the end of every mailbox's select list
+    for (int i = 0; i < count; i++) {
+        mailboxPtr mbptr = &MailBoxTable[mbox_ids[i]];
+        selectNodePtr node = &SelectNodes[pid % MAXPROC][i];
+
+        node->proc = proc;
+        node->mboxID = mbox_ids[i];
+        node->next = NULL;
+        node->prev = mbptr->selectTail;
+        if (mbptr->selectList == NULL) {
+            mbptr->selectList = node;
+        } else {
+            mbptr->selectTail->next = node;
+        }
+        mbptr->selectTail = node;
+    }
+    proc->numSelect = count;
+
+    // block until a sender picks this process in claimSelector
+    blockMe(RECV_BLOCK);
+
+    // process was zapped or a mailbox was released
+    if (proc->mboxReleased || isZapped()) {
+        cancelSelect(proc);
+        enableInterrupts();
+        return -3;
+    }
+
+    *which = proc->selectMbox;
+
+    // failed to receive message from sender
+    if (proc->status == FAILED) {
+        enableInterrupts();
+        return -1;
     }
-    timeSlice();
     enableInterrupts();
-} /* clockHandler */
+    return proc->msgSize;
+} /* MboxReceiveAny */
 
 /* ------------------------------------------------------------------------
-   Name - diskHandler
-   Purpose - called when interrupt vector is activated for this device
-   Parameters - device, unit
-   Returns - void
-   Side Effects - none
+   Name - MboxAllocBuf
+   Purpose - Gets a kernel buffer for MboxSendRef from the message slabs.
+             The caller owns it until it is sent or freed.
+   Parameters - size of the buffer in bytes, at most MBOX_MAX_MESSAGE
+   Returns - pointer to the buffer, or NULL if size is invalid or there is
+             no room left in the slabs.
+   Side Effects - none.
    ----------------------------------------------------------------------- */
-void diskHandler(int dev, long unit) {
-    check_kernel_mode("diskHandler");
+void *MboxAllocBuf(int size) {
+    check_kernel_mode("MboxAllocBuf");
     disableInterrupts();
 
-    if (dev != USLOSS_DISK_INT || unit < 0 || unit > 1) {
-        USLOSS_Console("diskHandler(): wrong device or unit\n");
-        USLOSS_Halt(1);
+    char *buf = NULL;
+    if (size >= 0 && size <= MBOX_MAX_MESSAGE) {
+        buf = allocBuf(size);
     }
-    int status;
-    int mailboxID = unit + 1;
+    enableInterrupts();
+    return buf;
+} /* MboxAllocBuf */
 
-    USLOSS_DeviceInput(USLOSS_DISK_INT, unit, &status);
-    MboxCondSend(mailboxID, &status, sizeof(int));
+/* ------------------------------------------------------------------------
+   Name - MboxFreeBuf
+   Purpose - Returns a buffer from MboxAllocBuf or MboxReceiveRef.
+   Parameters - the buffer
+   Returns - 0 if successful, -1 if buf is not an allocated buffer.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxFreeBuf(void *buf) {
+    check_kernel_mode("MboxFreeBuf");
+    disableInterrupts();
+
+    if (getBufHeader(buf) == NULL) {
+        enableInterrupts();
+        return -1;
+    }
+    freeBuf(buf);
     enableInterrupts();
-} /* diskHandler */
+    return 0;
+} /* MboxFreeBuf */
 
 /* ------------------------------------------------------------------------
-   Name - termHandler
-   Purpose - called when interrupt vector is activated for this device
-   Parameters - device, unit
-   Returns - void
-   Side Effects - none
+   Name - MboxSendRef
+   Purpose - Like MboxSend, but the message is a buffer from MboxAllocBuf
+             that is put in a slot as is, without copying. The buffer then
+             belongs to the mailbox, and to the receiver after that. Only
+             for mailboxes with slots.
+   Parameters - mailbox id, the buffer, # of bytes in msg.
+   Returns - zero if successful, -1 if invalid args, -3 if zapped or the
+             mailbox was released, in which case the caller still owns
+             the buffer.
+   Side Effects - none.
    ----------------------------------------------------------------------- */
-void termHandler(int dev, long unit) {
-    check_kernel_mode("termHandler");
+int MboxSendRef(int mbox_id, void *buf, int msg_size) {
+    check_kernel_mode("MboxSendRef");
     disableInterrupts();
 
-    if (dev != USLOSS_TERM_INT || unit < 0 || unit > 3) {
-        USLOSS_Console("termHandler(): wrong device or unit\n");
+    // error checking for parameters
+    if (mbox_id >= MAXMBOX || mbox_id < 0 ||
+            MailBoxTable[mbox_id].status == EMPTY ||
+            MailBoxTable[mbox_id].broadcast) {
+        enableInterrupts();
+        return -1;
+    }
+
+    mailboxPtr mbptr = &MailBoxTable[mbox_id]; // pointer to mailbox
+    bufHeader *header = getBufHeader(buf);
+
+    if (mbptr->numSlots == 0 || header == NULL || msg_size < 0 ||
+            msg_size > header->size || msg_size > mbptr->slotSize) {
+        enableInterrupts();
+        return -1;
+    }
+
+    // Add process to Process Table
+    int pid = getpid();
+    MboxProcTable[pid % MAXPROC].pid = pid;
+    MboxProcTable[pid % MAXPROC].status = ACTIVE;
+    MboxProcTable[pid % MAXPROC].message = buf;
+    MboxProcTable[pid % MAXPROC].msgSize = msg_size;
+    MboxProcTable[pid % MAXPROC].isRef = 1;
+    MboxProcTable[pid % MAXPROC].msgPriority = MSG_PRIO_DEFAULT;
+    claimSelector(mbptr);
+
+    // Block if no available slots and no process on recv list, until a
+    // receiver moves the buffer into a slot
+    if (mbptr->numSlots <= mbptr->slotsUsed && mbptr->blockRecvList == NULL) {
+        addToBlockSendList(mbptr, &MboxProcTable[pid % MAXPROC]);
+#ifdef OWN_PHASE1
+        blockMeOn(SEND_BLOCK, mbptr->lastReceiver);
+#else
+        blockMe(SEND_BLOCK);
+#endif
+        if(MboxProcTable[pid % MAXPROC].mboxReleased){
+          enableInterrupts();
+          return -3;
+        }
+        return isZapped() ? -3 : 0;
+    }
+
+    // hand the buffer to a blocked receiver, copying only if it is in
+    // MboxReceive
+    if (mbptr->blockRecvList != NULL) {
+        mboxProcPtr receiver = mbptr->blockRecvList;
+
+        if (msg_size > receiver->msgSize) {
+            receiver->status = FAILED;
+            removeFromBlockRecvList(mbptr, receiver);
+            unblockProc(receiver->pid);
+            enableInterrupts();
+            return -1;
+        }
+        if (receiver->isRef) {
+            *(void **) receiver->message = buf;
+        } else {
+            memcpy(receiver->message, buf, msg_size);
+            freeBuf(buf);
+        }
+        receiver->msgSize = msg_size;
+        removeFromBlockRecvList(mbptr, receiver);
+        unblockProc(receiver->pid);
+        enableInterrupts();
+        return isZapped() ? -3 : 0;
+    }
+
+    // put the buffer itself in a slot
+    int slot = getSlotIndex();
+    if (slot == -2) {
+        USLOSS_Console("MboxSendRef(): No slots in system. Halting...\n");
         USLOSS_Halt(1);
     }
-    int status;
-    int mailboxID = unit + 3;
+    addSlotToList(initRefSlot(slot, mbptr->mboxID, buf, msg_size), mbptr);
 
-    USLOSS_DeviceInput(USLOSS_TERM_INT, unit, &status);
-    MboxCondSend(mailboxID, &status, sizeof(int));
     enableInterrupts();
-} /* termHandler */
+    return isZapped() ? -3 : 0;
+} /* MboxSendRef */
 
 /* ------------------------------------------------------------------------
-   Name - syscallHandler
-   Purpose - called when interrupt vector is activated for this device
-   Parameters - device, unit
-   Returns - void
-   Side Effects - none
+   Name - MboxReceiveRef
+   Purpose - Like MboxReceive, but gives the caller the buffer holding the
+             message instead of copying it out. A message sent with
+             MboxSendRef is not copied at all; any other is copied once,
+             into a new buffer. Only for mailboxes with slots.
+   Parameters - mailbox id, where to put the pointer to the buffer, which
+                the caller must free with MboxFreeBuf.
+   Returns - size of the msg if successful, -1 if invalid args or no
+             buffer could be had for a copied msg, -3 if zapped or the
+             mailbox was released.
+   Side Effects - none.
    ----------------------------------------------------------------------- */
-void syscallHandler(int dev, void *unit) {
-    check_kernel_mode("syscallHandler");
+int MboxReceiveRef(int mbox_id, void **buf) {
+    check_kernel_mode("MboxReceiveRef");
     disableInterrupts();
 
-    systemArgs *args = unit;
-    int sysCall = args->number;
+    // error checking for parameters
+    if (mbox_id >= MAXMBOX || mbox_id < 0 ||
+            MailBoxTable[mbox_id].status == EMPTY ||
+            MailBoxTable[mbox_id].broadcast || buf == NULL) {
+        enableInterrupts();
+        return -1;
+    }
 
-    if (dev != USLOSS_SYSCALL_INT || sysCall < 0 || sysCall >= MAXSYSCALLS) {
-        USLOSS_Console("syscallHandler(): sys number %d is wrong.  Halting...\n",
-                sysCall);
-        USLOSS_Halt(1);
+    mailboxPtr mbptr = &MailBoxTable[mbox_id]; // pointer to mailbox
+
+    if (mbptr->numSlots == 0) {
+        enableInterrupts();
+        return -1;
+    }
+
+    // Add process to Process Table
+    int pid = getpid();
+    MboxProcTable[pid % MAXPROC].pid = pid;
+    MboxProcTable[pid % MAXPROC].status = ACTIVE;
+    MboxProcTable[pid % MAXPROC].message = buf;
+    MboxProcTable[pid % MAXPROC].msgSize = MBOX_MAX_MESSAGE;
+    MboxProcTable[pid % MAXPROC].isRef = 1;
+    mbptr->lastReceiver = pid;
+
+    slotPtr slotptr = mbptr->slotList; // pointer to first slot in list
+
+    // block until a sender hands over a message
+    if (slotptr == NULL) {
+        addToBlockRecvList(mbptr, &MboxProcTable[pid % MAXPROC]);
+        blockMe(RECV_BLOCK);
+
+        if(MboxProcTable[pid % MAXPROC].mboxReleased || isZapped()){
+           enableInterrupts();
+           return -3;
+        }
+        if(MboxProcTable[pid % MAXPROC].status == FAILED) {
+            enableInterrupts();
+            return -1;
+        }
+        enableInterrupts();
+        return MboxProcTable[pid % MAXPROC].msgSize;
+    }
+
+    // take the slot's buffer, or copy a plain message into a new one
+    int msgSize = slotptr->msgSize;
+    if (slotptr->isRef) {
+        *buf = slotptr->message;
+        slotptr->message = NULL;
+    } else {
+        *buf = allocBuf(msgSize);
+        if (*buf == NULL) {
+            enableInterrupts();
+            return -1;
+        }
+        memcpy(*buf, slotptr->message, msgSize);
+    }
+    removeFirstSlot(mbptr);
+    freeSlot(slotptr->slotID);
+    mbptr->slotsUsed--;
+
+    // there is a message on the send list waiting for a slot
+    if (mbptr->blockSendList != NULL) {
+        moveSenderToSlot(mbptr);
     }
-    (*systemCallVec[sysCall])(args);
     enableInterrupts();
-} /* syscallHandler */
+    return isZapped() ? -3 : msgSize;
+} /* MboxReceiveRef */
 
-/*
- * Returns the index of the next available slot from the slot array or -2 if
- * no available slot.
- */
-int getSlotIndex() {
-    for (int i = 0; i < MAXSLOTS; i++) {
-        if (SlotTable[i].status == EMPTY) {
-           return i;
+/* ------------------------------------------------------------------------
+   Name - MboxCreatePriority
+   Purpose - Creates a mailbox that keeps its messages in priority order,
+             most urgent first and FIFO within a priority, and serves its
+             blocked senders in the order of their messages' priorities.
+   Parameters - number of slots, largest message.
+   Returns - mailbox id, -1 if no more mailboxes, -2 if invalid args
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxCreatePriority(int slots, int slot_size) {
+    check_kernel_mode("MboxCreatePriority");
+
+    int mbox_id = MboxCreate(slots, slot_size);
+    if (mbox_id >= 0) {
+        MailBoxTable[mbox_id].priorityOrder = 1;
+    }
+    return mbox_id;
+} /* MboxCreatePriority */
+
+/* ------------------------------------------------------------------------
+   Name - MboxCreateBroadcast
+   Purpose - Creates a broadcast mailbox. Each message published to it is
+             kept once, in one slot, until every subscriber has read it
+             at its own cursor.
+   Parameters - most messages kept, largest message, and what MboxPublish
+                does when it is full: BCAST_OVERWRITE drops the oldest
+                message, BCAST_BLOCK waits for the subscribers to read it.
+   Returns - mailbox id, -1 if no more mailboxes, -2 if invalid args
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxCreateBroadcast(int slots, int slot_size, int policy) {
+    check_kernel_mode("MboxCreateBroadcast");
+
+    if (slots < 1 || (policy != BCAST_OVERWRITE && policy != BCAST_BLOCK)) {
+        return -2;
+    }
+    int mbox_id = MboxCreate(slots, slot_size);
+    if (mbox_id >= 0) {
+        MailBoxTable[mbox_id].broadcast = policy;
+    }
+    return mbox_id;
+} /* MboxCreateBroadcast */
+
+/* ------------------------------------------------------------------------
+   Name - MboxSubscribe
+   Purpose - Adds a subscriber to a broadcast mailbox. It gets every
+             message published after this call.
+   Parameters - mailbox id
+   Returns - subscriber id, -1 if invalid args or no more subscribers
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxSubscribe(int mbox_id) {
+    check_kernel_mode("MboxSubscribe");
+    disableInterrupts();
+
+    if (mbox_id < 0 || mbox_id >= MAXMBOX ||
+            MailBoxTable[mbox_id].status == EMPTY ||
+            !MailBoxTable[mbox_id].broadcast || FreeSubs == NULL) {
+        enableInterrupts();
+        return -1;
+    }
+    mailboxPtr mbptr = &MailBoxTable[mbox_id];
+    bcastSub *sub = FreeSubs;
+
+    FreeSubs = sub->nextSub;
+    sub->mboxID = mbox_id;
+    sub->nextSeq = mbptr->nextSeq;
+    sub->missed = 0;
+    sub->waiter = -1;
+    sub->nextSub = mbptr->subList;
+    mbptr->subList = sub;
+    mbptr->numSubs++;
+    enableInterrupts();
+    return sub - BcastSubs;
+} /* MboxSubscribe */
+
+/* ------------------------------------------------------------------------
+   Name - MboxUnsubscribe
+   Purpose - Removes a subscriber, giving up the messages it has not read.
+   Parameters - subscriber id
+   Returns - 0 if successful, -1 if invalid args or a process is blocked
+             in MboxReceiveSub for the subscriber
+   Side Effects - may wake a publisher blocked on a full mailbox.
+   ----------------------------------------------------------------------- */
+int MboxUnsubscribe(int sub_id) {
+    check_kernel_mode("MboxUnsubscribe");
+    disableInterrupts();
+
+    if (sub_id < 0 || sub_id >= MAXSUBSCRIBERS ||
+            BcastSubs[sub_id].mboxID == -1 || BcastSubs[sub_id].waiter != -1) {
+        enableInterrupts();
+        return -1;
+    }
+    bcastSub *sub = &BcastSubs[sub_id];
+    mailboxPtr mbptr = &MailBoxTable[sub->mboxID];
+
+    // the messages it has not read no longer wait for it
+    for (slotPtr slotptr = mbptr->slotList; slotptr != NULL;
+            slotptr = slotptr->nextSlot) {
+        if (slotptr->seq >= sub->nextSeq) {
+            slotptr->refs--;
         }
     }
-    return -2;
-}
 
-/*
- *Initializes a new slot in the slot tables
- */
-slotPtr initSlot(int slotIndex, int mboxID, void *msg_ptr, int msg_size) {
-    SlotTable[slotIndex].mboxID = mboxID;
-    SlotTable[slotIndex].status = USED;
-    memcpy(SlotTable[slotIndex].message, msg_ptr, msg_size);
-    SlotTable[slotIndex].msgSize = msg_size;
-    return &SlotTable[slotIndex];
-}
+    // take it off the mailbox's subscriber list
+    bcastSub **link = &mbptr->subList;
+    while (*link != sub) {
+        link = &(*link)->nextSub;
+    }
+    *link = sub->nextSub;
+    mbptr->numSubs--;
 
-/*
- *Adds a slot to the slot list for a mailbox
- */
-int addSlotToList(slotPtr slotToAdd, mailboxPtr mbptr) {
-    slotPtr head = mbptr->slotList;
-    if (head == NULL) {
-        mbptr->slotList = slotToAdd;
-    } else {
-        while (head->nextSlot != NULL) {
-            head = head->nextSlot;
+    sub->mboxID = -1;
+    sub->nextSub = FreeSubs;
+    FreeSubs = sub;
+    trimBroadcast(mbptr);
+    enableInterrupts();
+    return 0;
+} /* MboxUnsubscribe */
+
+/* ------------------------------------------------------------------------
+   Name - MboxPublish
+   Purpose - Puts one copy of a message in a broadcast mailbox for all of
+             its subscribers, and wakes those waiting for it. If the
+             mailbox is full, drops the oldest message or blocks, as its
+             policy says. A message is not kept if there are no
+             subscribers.
+   Parameters - mailbox id, pointer to data of msg, # of bytes in msg.
+   Returns - zero if successful, -1 if invalid args, -3 if zapped or the
+             mailbox was released.
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxPublish(int mbox_id, void *msg_ptr, int msg_size) {
+    check_kernel_mode("MboxPublish");
+    disableInterrupts();
+
+    if (mbox_id < 0 || mbox_id >= MAXMBOX ||
+            MailBoxTable[mbox_id].status == EMPTY ||
+            !MailBoxTable[mbox_id].broadcast || msg_size < 0 ||
+            msg_size > MailBoxTable[mbox_id].slotSize) {
+        enableInterrupts();
+        return -1;
+    }
+    mailboxPtr mbptr = &MailBoxTable[mbox_id];
+    int pid = getpid();
+    MboxProcTable[pid % MAXPROC].pid = pid;
+    MboxProcTable[pid % MAXPROC].mboxReleased = 0;
+
+    // make room, waiting for slow subscribers if the policy says so
+    while (mbptr->numSubs > 0 && mbptr->slotsUsed >= mbptr->numSlots) {
+        if (mbptr->broadcast == BCAST_OVERWRITE) {
+            dropOldest(mbptr);
+            continue;
+        }
+        addToBlockSendList(mbptr, &MboxProcTable[pid % MAXPROC]);
+        blockMe(SEND_BLOCK);
+        if (MboxProcTable[pid % MAXPROC].mboxReleased || isZapped()) {
+            enableInterrupts();
+            return -3;
         }
-        head->nextSlot = slotToAdd;
+        disableInterrupts();
     }
-    return ++mbptr->slotsUsed;
+
+    // no one to read it
+    if (mbptr->numSubs == 0) {
+        mbptr->nextSeq++;
+        enableInterrupts();
+        return isZapped() ? -3 : 0;
+    }
+
+    int slot = getSlotIndex();
+    slotPtr slotToAdd = NULL;
+    if (slot != -2) {
+        slotToAdd = initSlot(slot, mbptr->mboxID, msg_ptr, msg_size);
+    }
+    if (slot == -2) {
+        USLOSS_Console("MboxPublish(): No slots in system. Halting...\n");
+        USLOSS_Halt(1);
+    }
+    if (slotToAdd == NULL) {
+        USLOSS_Console("MboxPublish(): No room for the message in the slab "
+                       "arena. Halting...\n");
+        USLOSS_Halt(1);
+    }
+    slotToAdd->seq = mbptr->nextSeq++;
+    slotToAdd->refs = mbptr->numSubs;
+    addSlotToList(slotToAdd, mbptr);
+
+    // wake the subscribers waiting for it
+    int pids[MAXPROC];
+    int numPids = 0;
+    for (bcastSub *sub = mbptr->subList; sub != NULL; sub = sub->nextSub) {
+        if (sub->waiter != -1) {
+            pids[numPids++] = sub->waiter;
+            sub->waiter = -1;
+        }
+    }
+#ifdef OWN_PHASE1
+    unblockMany(pids, numPids);
+#else
+    for (int i = 0; i < numPids; i++) {
+        unblockProc(pids[i]);
+        disableInterrupts();
+    }
+#endif
+    enableInterrupts();
+    return isZapped() ? -3 : 0;
+} /* MboxPublish */
+
+/* ------------------------------------------------------------------------
+   Name - MboxReceiveSub
+   Purpose - Gets the next message for a subscriber of a broadcast
+             mailbox, blocking until one is published. The message is
+             freed once every subscriber has read it.
+   Parameters - subscriber id, pointer to put data of msg, max # of bytes
+                that can be received.
+   Returns - actual size of msg if successful, -1 if invalid args or the
+             msg is too big, in which case it stays next, -3 if zapped or
+             the mailbox was released.
+   Side Effects - may wake a publisher blocked on a full mailbox.
+   ----------------------------------------------------------------------- */
+int MboxReceiveSub(int sub_id, void *msg_ptr, int msg_size) {
+    check_kernel_mode("MboxReceiveSub");
+    disableInterrupts();
+
+    if (sub_id < 0 || sub_id >= MAXSUBSCRIBERS ||
+            BcastSubs[sub_id].mboxID == -1 ||
+            BcastSubs[sub_id].waiter != -1 || msg_size < 0) {
+        enableInterrupts();
+        return -1;
+    }
+    bcastSub *sub = &BcastSubs[sub_id];
+    mailboxPtr mbptr = &MailBoxTable[sub->mboxID];
+    int pid = getpid();
+    MboxProcTable[pid % MAXPROC].pid = pid;
+    MboxProcTable[pid % MAXPROC].mboxReleased = 0;
+
+    // block until something is published past the cursor
+    while (sub->nextSeq == mbptr->nextSeq) {
+        sub->waiter = pid;
+        blockMe(RECV_BLOCK);
+        if (MboxProcTable[pid % MAXPROC].mboxReleased) {
+            enableInterrupts();
+            return -3;
+        }
+        sub->waiter = -1;
+        if (isZapped()) {
+            enableInterrupts();
+            return -3;
+        }
+        disableInterrupts();
+    }
+
+    // messages are kept in order, so skip those it has read
+    slotPtr slotptr = mbptr->slotList;
+    while (slotptr->seq < sub->nextSeq) {
+        slotptr = slotptr->nextSlot;
+    }
+    if (slotptr->msgSize > msg_size) {
+        enableInterrupts();
+        return -1;
+    }
+    memcpy(msg_ptr, slotptr->message, slotptr->msgSize);
+    int msgSize = slotptr->msgSize;
+    sub->nextSeq = slotptr->seq + 1;
+    slotptr->refs--;
+    trimBroadcast(mbptr);
+    enableInterrupts();
+    return isZapped() ? -3 : msgSize;
+} /* MboxReceiveSub */
+
+/* ------------------------------------------------------------------------
+   Name - MboxSubStats
+   Purpose - Reports how far a subscriber is behind.
+   Parameters - subscriber id, where to put the # of msgs published that
+                it has not read, and the # it missed to BCAST_OVERWRITE.
+   Returns - 0 if successful, -1 if invalid args
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int MboxSubStats(int sub_id, int *pending, int *missed) {
+    check_kernel_mode("MboxSubStats");
+
+    if (sub_id < 0 || sub_id >= MAXSUBSCRIBERS ||
+            BcastSubs[sub_id].mboxID == -1) {
+        return -1;
+    }
+    *pending = MailBoxTable[BcastSubs[sub_id].mboxID].nextSeq -
+               BcastSubs[sub_id].nextSeq;
+    *missed = BcastSubs[sub_id].missed;
+    return 0;
+} /* MboxSubStats */
+
+/* ------------------------------------------------------------------------
+   Name - waitDevice
+   Purpose - Block the process on the device until the device sends msg,
+             unless a status came in while no process was waiting.
+   Parameters - type, unit, status
+   Returns - -1 if zapped, 0 otherwise
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int waitDevice(int type, int unit, int *status){
+    check_kernel_mode("waitDevice");
+    disableInterrupts();
+
+    int returnCode;               // -1 if process was zapped, 0 otherwise
+    int deviceID;                 // the index of the i/o mailbox
+    int clockID = 0;              // index of the clock i/o mailbox
+    int diskID[] = {1, 2};        // indexes of the disk i/o mailboxes
+    int termID[] = {3, 4, 5, 6};  // indexes of the terminal i/o mailboxes
+
+    // determine the index of the i/o mailbox for the given device type and unit
+    switch (type) {
+        case USLOSS_CLOCK_INT:
+            deviceID = clockID;
+            break;
+        case USLOSS_DISK_INT:
+            if (unit >  1 || unit < 0) {
+                USLOSS_Console("waitDevice(): invalid unit  Halting\n");
+		USLOSS_Halt(1);
+            }
+            deviceID = diskID[unit];
+            break;
+        case USLOSS_TERM_INT:
+            if (unit >  3 || unit < 0) {
+                USLOSS_Console("waitDevice(): invalid unit  Halting...\n");
+		USLOSS_Halt(1);
+            }
+            deviceID = termID[unit];
+            break;
+        default:
+            USLOSS_Console("waitDevice(): invalid device or unit type  Halting...\n");
+	    USLOSS_Halt(1);
+    }
+
+    // take a status that came while no process was waiting
+    if (takeDeviceStatus(deviceID, status)) {
+        enableInterrupts();
+        return isZapped() ? -1 : 0;
+    }
+
+    // wait for status of device
+    returnCode = MboxReceive(deviceID, status, sizeof(int));
+    return returnCode == -3 ? -1 : 0;
+}
+
+/* ------------------------------------------------------------------------
+   Name - deviceStats
+   Purpose - Reports on the status ring of a device unit.
+   Parameters - type, unit, where to put the # of statuses waiting for
+                waitDevice, the # of clock statuses replaced by newer
+                ones, and the # of statuses dropped with the ring full.
+   Returns - -1 if invalid device or unit, 0 otherwise
+   Side Effects - none.
+   ----------------------------------------------------------------------- */
+int deviceStats(int type, int unit, int *queued, int *coalesced,
+                int *overflows) {
+    check_kernel_mode("deviceStats");
+    disableInterrupts();
+
+    int deviceID;  // the index of the i/o mailbox
+
+    if (type == USLOSS_CLOCK_INT && unit == 0) {
+        deviceID = CLOCK_MBOX;
+    } else if (type == USLOSS_DISK_INT && unit >= 0 && unit <= 1) {
+        deviceID = unit + 1;
+    } else if (type == USLOSS_TERM_INT && unit >= 0 && unit <= 3) {
+        deviceID = unit + 3;
+    } else {
+        enableInterrupts();
+        return -1;
+    }
+
+    devRing *ring = &DeviceRings[deviceID];
+    *queued = ring->tail - ring->head;
+    *coalesced = ring->coalesced;
+    *overflows = ring->overflows;
+    enableInterrupts();
+    return 0;
+} /* deviceStats */
+
+/* 
+ *check_kernel_mode
+ */
+void check_kernel_mode(char * processName) {
+    if((USLOSS_PSR_CURRENT_MODE & USLOSS_PsrGet()) == 0) {
+        USLOSS_Console("check_kernal_mode(): called while in user mode, by"
+                " process %s. Halting...\n", processName);
+        USLOSS_Halt(1);
+    } 
+}
+
+/*
+ *enable_interrupts 
+ */
+void enableInterrupts() {
+    USLOSS_PsrSet(USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT);
+}
+
+/*
+ * Disables the interrupts.
+ */
+void disableInterrupts() {
+    USLOSS_PsrSet( USLOSS_PsrGet() & ~USLOSS_PSR_CURRENT_INT );
+} /* disableInterrupts */
+
+/*
+ * checks if any procs are blocked on io mailbox, or waiting for a timeout
+ */
+int check_io() {
+    if (numTimers > 0) {
+        return 1;
+    }
+    for (int i = 0; i < 7; i++) { 
+        if (MailBoxTable[i].blockRecvList != NULL ||
+                MailBoxTable[i].selectList != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ *Zeros all elements of the mailbox for that id
+ */
+void zeroMailbox(int mboxID) {
+    MailBoxTable[mboxID].numSlots = -1;
+    MailBoxTable[mboxID].slotsUsed = -1;
+    MailBoxTable[mboxID].slotSize = -1;
+    MailBoxTable[mboxID].blockSendList = NULL;
+    MailBoxTable[mboxID].blockSendTail = NULL;
+    MailBoxTable[mboxID].blockRecvList = NULL;
+    MailBoxTable[mboxID].blockRecvTail = NULL;
+    MailBoxTable[mboxID].slotList = NULL;
+    MailBoxTable[mboxID].slotTail = NULL;
+    MailBoxTable[mboxID].status = EMPTY;
+    MailBoxTable[mboxID].lastReceiver = -1;
+    MailBoxTable[mboxID].selectList = NULL;
+    MailBoxTable[mboxID].selectTail = NULL;
+    MailBoxTable[mboxID].broadcast = 0;
+    MailBoxTable[mboxID].nextSeq = 0;
+    MailBoxTable[mboxID].subList = NULL;
+    MailBoxTable[mboxID].numSubs = 0;
+    MailBoxTable[mboxID].priorityOrder = 0;
+    for (int i = 0; i < NUMMSGPRIOS; i++) {
+        MailBoxTable[mboxID].slotPrioTail[i] = NULL;
+    }
+    setMboxFree(mboxID, 1);
+}
+
+/*
+ *Zeros all elements of the slot for that id
+ */
+void zeroSlot(int slotID) {
+    SlotTable[slotID].mboxID = -1;
+    SlotTable[slotID].status = EMPTY;
+    SlotTable[slotID].message = NULL;
+    SlotTable[slotID].slabClass = -1;
+    SlotTable[slotID].isRef = 0;
+    SlotTable[slotID].seq = 0;
+    SlotTable[slotID].refs = 0;
+    SlotTable[slotID].priority = MSG_PRIO_DEFAULT;
+    SlotTable[slotID].nextSlot = NULL;
+}
+
+/*
+ *Frees a slot's message, zeros the slot and pushes it on the free slot list
+ */
+void freeSlot(int slotID) {
+    if (SlotTable[slotID].message != NULL && SlotTable[slotID].isRef) {
+        freeBuf(SlotTable[slotID].message);
+    } else if (SlotTable[slotID].message != NULL) {
+        freeMessage(SlotTable[slotID].message, SlotTable[slotID].slabClass);
+    }
+    zeroSlot(slotID);
+    SlotTable[slotID].nextSlot = FreeSlots;
+    FreeSlots = &SlotTable[slotID];
+}
+
+/*
+ *Marks a mailbox free or in use in the free mailbox bitmaps
+ */
+void setMboxFree(int mboxID, int isFree) {
+    int word = mboxID / 64;
+    unsigned long long bit = 1ULL << (mboxID % 64);
+
+    if (isFree) {
+        FreeMboxes[word] |= bit;
+        MboxSummary[word / 64] |= 1ULL << (word % 64);
+    } else {
+        FreeMboxes[word] &= ~bit;
+        if (FreeMboxes[word] == 0) {
+            MboxSummary[word / 64] &= ~(1ULL << (word % 64));
+        }
+    }
+}
+
+/*
+ *Zeros all elements of the process for that id
+ */
+void zeroMboxProc(int pid) {
+   MboxProcTable[pid % MAXPROC].pid = -1; 
+   MboxProcTable[pid % MAXPROC].status = EMPTY; 
+   MboxProcTable[pid % MAXPROC].message = NULL; 
+   MboxProcTable[pid % MAXPROC].msgSize = -1; 
+   MboxProcTable[pid % MAXPROC].isRef = 0;
+   MboxProcTable[pid % MAXPROC].mboxReleased = 0; 
+   MboxProcTable[pid % MAXPROC].nextBlockSend = NULL; 
+   MboxProcTable[pid % MAXPROC].prevBlockSend = NULL;
+   MboxProcTable[pid % MAXPROC].nextBlockRecv = NULL; 
+   MboxProcTable[pid % MAXPROC].prevBlockRecv = NULL;
+   MboxProcTable[pid % MAXPROC].waitMbox = -1;
+   MboxProcTable[pid % MAXPROC].blockType = 0;
+   MboxProcTable[pid % MAXPROC].timerIndex = -1;
+   MboxProcTable[pid % MAXPROC].deadline = 0;
+   MboxProcTable[pid % MAXPROC].timedOut = 0;
+   MboxProcTable[pid % MAXPROC].numSelect = 0;
+   MboxProcTable[pid % MAXPROC].selectMbox = -1;
+   MboxProcTable[pid % MAXPROC].msgPriority = MSG_PRIO_DEFAULT;
+   MboxProcTable[pid % MAXPROC].sysCallPid = -1;
+}
+
+/* an error method to handle invalid syscalls */
+void nullsys(systemArgs *args)
+{
+    USLOSS_Console("nullsys(): Invalid syscall %d. Halting...\n", args->number);
+    USLOSS_Halt(1);
+} /* nullsys */
+
+/* ------------------------------------------------------------------------
+   Name - clockHandler2
+   Purpose - called when interrupt vector is activated for this device
+   Parameters - device, unit
+   Returns - void
+   Side Effects - increases clock counted by 1, wakes processes whose
+                  MboxSendTimed or MboxReceiveTimed timed out.
+   ----------------------------------------------------------------------- */
+void clockHandler2(int dev, long unit) {
+    check_kernel_mode("clockHandler2");
+    disableInterrupts();
+
+    if (dev != USLOSS_CLOCK_INT || unit != 0) {
+        USLOSS_Console("clockHandler2(): wrong device or unit\n");
+        USLOSS_Halt(1);
+    }
+    int status;
+
+    clockCounter++;
+    if (clockCounter >= 5) {
+        USLOSS_DeviceInput(USLOSS_CLOCK_INT, 0, &status);
+        postDeviceStatus(CLOCK_MBOX, status);
+        clockCounter = 0;
+    }
+    expireTimers();
+    timeSlice();
+    enableInterrupts();
+} /* clockHandler */
+
+/* ------------------------------------------------------------------------
+   Name - diskHandler
+   Purpose - called when interrupt vector is activated for this device
+   Parameters - device, unit
+   Returns - void
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void diskHandler(int dev, long unit) {
+    check_kernel_mode("diskHandler");
+    disableInterrupts();
+
+    if (dev != USLOSS_DISK_INT || unit < 0 || unit > 1) {
+        USLOSS_Console("diskHandler(): wrong device or unit\n");
+        USLOSS_Halt(1);
+    }
+    int status;
+    int mailboxID = unit + 1;
+
+    USLOSS_DeviceInput(USLOSS_DISK_INT, unit, &status);
+    postDeviceStatus(mailboxID, status);
+    enableInterrupts();
+} /* diskHandler */
+
+/* ------------------------------------------------------------------------
+   Name - termHandler
+   Purpose - called when interrupt vector is activated for this device
+   Parameters - device, unit
+   Returns - void
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void termHandler(int dev, long unit) {
+    check_kernel_mode("termHandler");
+    disableInterrupts();
+
+    if (dev != USLOSS_TERM_INT || unit < 0 || unit > 3) {
+        USLOSS_Console("termHandler(): wrong device or unit\n");
+        USLOSS_Halt(1);
+    }
+    int status;
+    int mailboxID = unit + 3;
+
+    USLOSS_DeviceInput(USLOSS_TERM_INT, unit, &status);
+    postDeviceStatus(mailboxID, status);
+    enableInterrupts();
+} /* termHandler */
+
+/* ------------------------------------------------------------------------
+   Name - syscallHandler
+   Purpose - called when interrupt vector is activated for this device
+   Parameters - device, unit
+   Returns - void
+   Side Effects - counts the call, and its time if it returns, in
+                  SyscallStats
+   ----------------------------------------------------------------------- */
+void syscallHandler(int dev, void *unit) {
+    check_kernel_mode("syscallHandler");
+    disableInterrupts();
+
+    systemArgs *args = unit;
+    int sysCall = args->number;
+
+    if (dev != USLOSS_SYSCALL_INT || sysCall < 0 || sysCall >= MAXSYSCALLS) {
+        USLOSS_Console("syscallHandler(): sys number %d is wrong.  Halting...\n",
+                sysCall);
+        USLOSS_Halt(1);
+    }
+    dispatchSyscall(args);
+    /* the handler may have set user mode, where USLOSS_PsrSet traps */
+    if (USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) {
+        enableInterrupts();
+    }
+} /* syscallHandler */
+
+/* ------------------------------------------------------------------------
+   Name - mboxSendMany
+   Purpose - System call handler for MboxSendMany
+   Parameters - args: arg1 mailbox id, arg2 messages, arg3 sizes,
+                arg4 # of messages
+   Returns - void, the result of MboxSendMany is put in arg4
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void mboxSendMany(systemArgs *args) {
+    args->arg4 = (void *) (long) MboxSendMany((int) (long) args->arg1,
+            args->arg2, args->arg3, (int) (long) args->arg4);
+} /* mboxSendMany */
+
+/* ------------------------------------------------------------------------
+   Name - mboxReceiveMany
+   Purpose - System call handler for MboxReceiveMany
+   Parameters - args: arg1 mailbox id, arg2 buffers, arg3 buffer sizes,
+                set to the sizes received, arg4 # of buffers
+   Returns - void, the result of MboxReceiveMany is put in arg4
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void mboxReceiveMany(systemArgs *args) {
+    args->arg4 = (void *) (long) MboxReceiveMany((int) (long) args->arg1,
+            args->arg2, args->arg3, (int) (long) args->arg4);
+} /* mboxReceiveMany */
+
+/* ------------------------------------------------------------------------
+   Name - syscallStatsCall
+   Purpose - System call handler for getSyscallStats
+   Parameters - args: arg1 system call number, arg2 the syscallStats to
+                fill in
+   Returns - void, the result of getSyscallStats is put in arg4
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void syscallStatsCall(systemArgs *args) {
+    args->arg4 = (void *) (long) getSyscallStats((int) (long) args->arg1,
+            args->arg2);
+} /* syscallStatsCall */
+
+/* ------------------------------------------------------------------------
+   Name - ringEnterCall
+   Purpose - System call handler for ringEnter
+   Parameters - args: arg1 the sysRing, arg2 # of entries to run
+   Returns - void, the result of ringEnter is put in arg4
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void ringEnterCall(systemArgs *args) {
+    args->arg4 = (void *) (long) ringEnter(args->arg1, (int) (long) args->arg2);
+} /* ringEnterCall */
+
+/* ------------------------------------------------------------------------
+   Name - ringEnter
+   Purpose - Runs up to count entries from the submission ring, in order,
+             one system call after the other, so one trap runs a batch.
+             Each entry goes to the completion ring with the results its
+             handler left in its args. Calls run to completion, blocking
+             if they must, so every entry taken has completed when
+             ringEnter returns. It stops early if the submission ring
+             runs out or the completion ring is full. An entry with an
+             invalid number, or one with no handler, completes with -1
+             in arg4. Handlers that end with setUserMode, as phase3's
+             do, leave the CPU in user mode, where USLOSS_PsrSet traps,
+             so the entries after one go through USLOSS_Syscall to run
+             in kernel mode.
+   Parameters - the sysRing, # of entries to run
+   Returns - # of entries run, -1 if invalid args
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+int ringEnter(sysRing *ring, int count) {
+    int done = 0;
+
+    if (ring == NULL || count < 0) {
+        return -1;
+    }
+    while (done < count && ring->sqHead != ring->sqTail &&
+            ring->cqTail - ring->cqHead < RING_ENTRIES) {
+        ringEntry entry = ring->sq[ring->sqHead++ % RING_ENTRIES];
+        int sysCall = entry.args.number;
+
+        if (sysCall < 0 || sysCall >= MAXSYSCALLS ||
+                sysCall == SYS_RINGENTER ||
+                systemCallVec[sysCall] == nullsys) {
+            entry.args.arg4 = (void *) -1L;
+        } else if (USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) {
+            dispatchSyscall(&entry.args);
+        } else {
+            /* an earlier handler set user mode; trap back into the kernel */
+            USLOSS_Syscall(&entry.args);
+        }
+        ring->cq[ring->cqTail++ % RING_ENTRIES] = entry;
+        done++;
+    }
+    return done;
+} /* ringEnter */
+
+/* ------------------------------------------------------------------------
+   Name - getSyscallStats
+   Purpose - Copies what syscallHandler has counted for a system call.
+   Parameters - system call number, the syscallStats to fill in
+   Returns - 0 if successful, -1 if invalid args
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+int getSyscallStats(int number, syscallStats *stats) {
+    if (number < 0 || number >= MAXSYSCALLS || stats == NULL) {
+        return -1;
+    }
+    *stats = SyscallStats[number];
+    return 0;
+} /* getSyscallStats */
+
+/* ------------------------------------------------------------------------
+   Name - dumpSyscallStats
+   Purpose - Prints the counts, errors and times of each system call that
+             has been made, with the non-empty log2 latency buckets.
+   Parameters - none
+   Returns - void
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void dumpSyscallStats(void) {
+    printSyscallStats(NULL);
+} /* dumpSyscallStats */
+
+/* ------------------------------------------------------------------------
+   Name - syscallDone
+   Purpose - Times the system call the current process is making, up to
+             now. Handlers that set user mode before returning, as
+             phase3's do, call it first, since USLOSS_Clock traps in user
+             mode. Otherwise dispatchSyscall times the call when the
+             handler returns.
+   Parameters - none
+   Returns - void
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void syscallDone(void) {
+    check_kernel_mode("syscallDone");
+    int pid = getpid();
+    mboxProcPtr proc = &MboxProcTable[pid % MAXPROC];
+
+    if (proc->sysCallPid != pid) {
+        return;
+    }
+    recordSyscall(proc->sysCall, USLOSS_Clock() - proc->sysCallStart,
+                  (long) proc->sysArgs->arg4 < 0);
+    proc->sysCallPid = -1;
+} /* syscallDone */
+
+/*
+ * Prints the system call table to file, or to the console if file is
+ * NULL
+ */
+void printSyscallStats(FILE *file) {
+    statsLine(file, "syscall  calls  errors   total(us)   min   avg   max\n");
+    for (int i = 0; i < MAXSYSCALLS; i++) {
+        syscallStats *stats = &SyscallStats[i];
+
+        if (stats->calls == 0) {
+            continue;
+        }
+        statsLine(file, "%7d %6d %7d %11lld %5d %5lld %5d\n", i, stats->calls,
+                stats->errors, stats->totalTime, stats->minTime,
+                stats->returned ? stats->totalTime / stats->returned : 0,
+                stats->maxTime);
+        for (int b = 0; b < SYSSTAT_BUCKETS; b++) {
+            if (stats->buckets[b] != 0) {
+                statsLine(file, "        < %8d us: %d\n", 1 << b,
+                        stats->buckets[b]);
+            }
+        }
+    }
+}
+
+/*
+ * Prints one line of the system call table, like printSyscallStats
+ */
+void statsLine(FILE *file, char *format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    if (file == NULL) {
+        USLOSS_VConsole(format, args);
+    } else {
+        vfprintf(file, format, args);
+    }
+    va_end(args);
+}
+
+/*
+ * Writes the system call table to SYSSTATS_FILE
+ */
+void writeSyscallStats(void) {
+    FILE *file = fopen(SYSSTATS_FILE, "w");
+
+    if (file == NULL) {
+        USLOSS_Console("writeSyscallStats(): could not open %s\n",
+                       SYSSTATS_FILE);
+        return;
+    }
+    printSyscallStats(file);
+    fclose(file);
+}
+
+/*
+ * Runs the handler of a system call, counting it and timing it in
+ * SyscallStats, unless the handler has timed it with syscallDone. A call
+ * whose handler sets user mode without calling syscallDone is counted
+ * but not timed.
+ */
+void dispatchSyscall(systemArgs *args) {
+    int sysCall = args->number;
+    int pid = getpid();
+    mboxProcPtr proc = &MboxProcTable[pid % MAXPROC];
+
+    // the call ringEnter runs this entry for, if any
+    int outerPid = proc->sysCallPid;
+    int outerCall = proc->sysCall;
+    int outerStart = proc->sysCallStart;
+    systemArgs *outerArgs = proc->sysArgs;
+
+    SyscallStats[sysCall].calls++;
+    proc->sysCallPid = pid;
+    proc->sysCall = sysCall;
+    proc->sysArgs = args;
+    proc->sysCallStart = USLOSS_Clock();
+    (*systemCallVec[sysCall])(args);
+    if (proc->sysCallPid == pid) {
+        if (USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) {
+            disableInterrupts();
+            syscallDone();
+        } else if ((long) args->arg4 < 0) {
+            /* the handler set user mode, where USLOSS_Clock traps */
+            SyscallStats[sysCall].errors++;
+        }
+    }
+    proc->sysCallPid = outerPid;
+    proc->sysCall = outerCall;
+    proc->sysCallStart = outerStart;
+    proc->sysArgs = outerArgs;
+}
+
+/*
+ * Adds the time of a system call that returned to its counters, in the
+ * log2 bucket of the time
+ */
+void recordSyscall(int sysCall, int time, int failed) {
+    syscallStats *stats = &SyscallStats[sysCall];
+    int bucket = 0;
+
+    while (bucket < SYSSTAT_BUCKETS - 1 && time >= (1 << bucket)) {
+        bucket++;
+    }
+    if (failed) {
+        stats->errors++;
+    }
+    stats->buckets[bucket]++;
+    stats->totalTime += time;
+    if (stats->returned++ == 0 || time < stats->minTime) {
+        stats->minTime = time;
+    }
+    if (time > stats->maxTime) {
+        stats->maxTime = time;
+    }
+}
+
+/*
+ * Takes a slot off the free slot list and returns its index, or -2 if no
+ * available slot.
+ */
+int getSlotIndex() {
+    slotPtr slot = FreeSlots;
+
+    if (slot == NULL) {
+        return -2;
+    }
+    FreeSlots = slot->nextSlot;
+    slot->nextSlot = NULL;
+    return slot->slotID;
+}
+
+/*
+ *Initializes a new slot in the slot tables. Returns NULL, and puts the slot
+ *back on the free list, if there is no room left for the message.
+ */
+slotPtr initSlot(int slotIndex, int mboxID, void *msg_ptr, int msg_size) {
+    int slabClass = -1;
+    char *message = NULL;
+
+    if (msg_size > 0) {
+        message = allocMessage(msg_size, &slabClass);
+        if (message == NULL) {
+            freeSlot(slotIndex);
+            return NULL;
+        }
+        memcpy(message, msg_ptr, msg_size);
+    }
+    SlotTable[slotIndex].mboxID = mboxID;
+    SlotTable[slotIndex].status = USED;
+    SlotTable[slotIndex].message = message;
+    SlotTable[slotIndex].msgSize = msg_size;
+    SlotTable[slotIndex].slabClass = slabClass;
+    return &SlotTable[slotIndex];
+}
+
+/*
+ *Returns a chunk of the smallest size class that holds size bytes, and
+ *sets *slabClass to its class. A chunk is taken from the class's free
+ *list, else carved from the arena, else borrowed from a larger class.
+ *Returns NULL if the arena is used up.
+ */
+char *allocMessage(int size, int *slabClass) {
+    int class = 0;
+
+    while (class < NUMSLABCLASSES - 1 && slabSizes[class] < size) {
+        class++;
+    }
+    if (slabSizes[class] < size) {
+        return NULL;
+    }
+
+    int chunkSize = (slabSizes[class] + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+    if (SlabFree[class] == NULL && slabUsed + chunkSize <= SLAB_BYTES) {
+        *slabClass = class;
+        slabUsed += chunkSize;
+        return &SlabArena[slabUsed - chunkSize];
+    }
+    for (; class < NUMSLABCLASSES; class++) {
+        if (SlabFree[class] != NULL) {
+            char *chunk = SlabFree[class];
+            SlabFree[class] = *(char **) chunk;
+            *slabClass = class;
+            return chunk;
+        }
+    }
+    return NULL;
+}
+
+/*
+ *Returns a chunk from allocMessage to its class's free list
+ */
+void freeMessage(char *message, int slabClass) {
+    *(char **) message = SlabFree[slabClass];
+    SlabFree[slabClass] = message;
+}
+
+/*
+ *Returns a buffer of size bytes, preceded by its bufHeader in the same
+ *chunk, or NULL if there is no room
+ */
+char *allocBuf(int size) {
+    int slabClass;
+    char *chunk = allocMessage(size + sizeof(bufHeader), &slabClass);
+
+    if (chunk == NULL) {
+        return NULL;
+    }
+    bufHeader *header = (bufHeader *) chunk;
+    header->magic = BUF_MAGIC;
+    header->slabClass = slabClass;
+    header->size = size;
+    return chunk + sizeof(bufHeader);
+}
+
+/*
+ *Returns a buffer from allocBuf to its class's free list
+ */
+void freeBuf(char *buf) {
+    bufHeader *header = (bufHeader *) (buf - sizeof(bufHeader));
+
+    header->magic = 0;
+    freeMessage((char *) header, header->slabClass);
+}
+
+/*
+ *Returns the header of a buffer from allocBuf, or NULL if buf is not one
+ */
+bufHeader *getBufHeader(void *buf) {
+    char *chunk = (char *) buf - sizeof(bufHeader);
+
+    if (buf == NULL || chunk < SlabArena ||
+            chunk >= SlabArena + slabUsed ||
+            (chunk - SlabArena) % SLAB_ALIGN != 0 ||
+            ((bufHeader *) chunk)->magic != BUF_MAGIC) {
+        return NULL;
+    }
+    return (bufHeader *) chunk;
+}
+
+/*
+ *Initializes a new slot that holds a buffer from allocBuf as its message
+ */
+slotPtr initRefSlot(int slotIndex, int mboxID, void *buf, int msg_size) {
+    SlotTable[slotIndex].mboxID = mboxID;
+    SlotTable[slotIndex].status = USED;
+    SlotTable[slotIndex].message = buf;
+    SlotTable[slotIndex].msgSize = msg_size;
+    SlotTable[slotIndex].slabClass = -1;
+    SlotTable[slotIndex].isRef = 1;
+    return &SlotTable[slotIndex];
+}
+
+/*
+ *Copies a message to a process blocked in MboxReceive, or for one in
+ *MboxReceiveRef, into a new buffer. Returns -1 if there was no room for
+ *the buffer.
+ */
+int copyToReceiver(mboxProcPtr receiver, void *msg_ptr, int msg_size) {
+    if (receiver->isRef) {
+        char *buf = allocBuf(msg_size);
+        if (buf == NULL) {
+            return -1;
+        }
+        memcpy(buf, msg_ptr, msg_size);
+        *(void **) receiver->message = buf;
+    } else {
+        memcpy(receiver->message, msg_ptr, msg_size);
+    }
+    return 0;
+}
+
+/*
+ *Moves the message of the first process on the send list into a free
+ *slot and wakes it. A buffer from MboxSendRef is moved without copying.
+ *The sender stays blocked if its message does not fit.
+ */
+void moveSenderToSlot(mailboxPtr mbptr) {
+    mboxProcPtr sender = mbptr->blockSendList;
+    int slotIndex = getSlotIndex();
+    slotPtr slotToAdd;
+
+    if (slotIndex == -2) {
+        return;
+    }
+    if (sender->isRef) {
+        slotToAdd = initRefSlot(slotIndex, mbptr->mboxID, sender->message,
+                                sender->msgSize);
+    } else {
+        slotToAdd = initSlot(slotIndex, mbptr->mboxID, sender->message,
+                             sender->msgSize);
+    }
+    if (slotToAdd == NULL) {
+        return;
+    }
+    slotToAdd->priority = sender->msgPriority;
+    addSlotToList(slotToAdd, mbptr);
+
+    // wake up the sender
+    removeFromBlockSendList(mbptr, sender);
+    unblockProc(sender->pid);
+}
+
+/*
+ *Adds a slot to the end of the slot list for a mailbox
+ */
+int addSlotToList(slotPtr slotToAdd, mailboxPtr mbptr) {
+    if (mbptr->priorityOrder) {
+        return addSlotByPriority(slotToAdd, mbptr);
+    }
+    slotToAdd->nextSlot = NULL;
+    if (mbptr->slotList == NULL) {
+        mbptr->slotList = slotToAdd;
+    } else {
+        mbptr->slotTail->nextSlot = slotToAdd;
+    }
+    mbptr->slotTail = slotToAdd;
+    return ++mbptr->slotsUsed;
+}
+
+/*
+ *Adds a slot to a priority-ordered mailbox, after the last slot of its
+ *priority, or else of the nearest more urgent one that has slots
+ */
+int addSlotByPriority(slotPtr slotToAdd, mailboxPtr mbptr) {
+    int priority = slotToAdd->priority;
+    slotPtr after = NULL;
+
+    for (int i = priority; i >= 0 && after == NULL; i--) {
+        after = mbptr->slotPrioTail[i];
+    }
+    if (after == NULL) {
+        slotToAdd->nextSlot = mbptr->slotList;
+        mbptr->slotList = slotToAdd;
+    } else {
+        slotToAdd->nextSlot = after->nextSlot;
+        after->nextSlot = slotToAdd;
+    }
+    if (slotToAdd->nextSlot == NULL) {
+        mbptr->slotTail = slotToAdd;
+    }
+    mbptr->slotPrioTail[priority] = slotToAdd;
+    return ++mbptr->slotsUsed;
+}
+
+/*
+ *Takes the first slot off a mailbox's slot list, without freeing it
+ */
+void removeFirstSlot(mailboxPtr mbptr) {
+    slotPtr slotptr = mbptr->slotList;
+
+    mbptr->slotList = slotptr->nextSlot;
+    if (mbptr->priorityOrder &&
+            mbptr->slotPrioTail[slotptr->priority] == slotptr) {
+        mbptr->slotPrioTail[slotptr->priority] = NULL;
+    }
+}
+
+/*
+ *Returns the place of a process on a priority-ordered mailbox's blocked
+ *lists, lower first: by process priority where our phase 1 gives it,
+ *FIFO otherwise, and then for senders by message priority
+ */
+int waitKey(mboxProcPtr proc, int isSender) {
+    int key = 0;
+
+#ifdef OWN_PHASE1
+    key = getPriority(proc->pid) * NUMMSGPRIOS;
+#endif
+    if (isSender) {
+        key += proc->msgPriority;
+    }
+    return key;
+}
+
+/*
+ *Adds a process to the end of a mailbox's blocked send list, or, for a
+ *priority-ordered mailbox, after the last sender with the same or a
+ *lower waitKey. The lists hold at most MAXPROC processes, and a FIFO
+ *append stops at the tail.
+ */
+void addToBlockSendList(mailboxPtr mbptr, mboxProcPtr proc) {
+    mboxProcPtr after = mbptr->blockSendTail;
+
+    if (mbptr->priorityOrder) {
+        proc->waitKey = waitKey(proc, 1);
+        while (after != NULL && after->waitKey > proc->waitKey) {
+            after = after->prevBlockSend;
+        }
+    }
+    proc->prevBlockSend = after;
+    if (after == NULL) {
+        proc->nextBlockSend = mbptr->blockSendList;
+        mbptr->blockSendList = proc;
+    } else {
+        proc->nextBlockSend = after->nextBlockSend;
+        after->nextBlockSend = proc;
+    }
+    if (proc->nextBlockSend == NULL) {
+        mbptr->blockSendTail = proc;
+    } else {
+        proc->nextBlockSend->prevBlockSend = proc;
+    }
+    proc->waitMbox = mbptr->mboxID;
+    proc->blockType = SEND_BLOCK;
+    proc->timedOut = 0;
+}
+
+/*
+ *Adds a process to the end of a mailbox's blocked receive list, or, for
+ *a priority-ordered mailbox, after the last receiver with the same or a
+ *lower waitKey
+ */
+void addToBlockRecvList(mailboxPtr mbptr, mboxProcPtr proc) {
+    mboxProcPtr after = mbptr->blockRecvTail;
+
+    if (mbptr->priorityOrder) {
+        proc->waitKey = waitKey(proc, 0);
+        while (after != NULL && after->waitKey > proc->waitKey) {
+            after = after->prevBlockRecv;
+        }
+    }
+    proc->prevBlockRecv = after;
+    if (after == NULL) {
+        proc->nextBlockRecv = mbptr->blockRecvList;
+        mbptr->blockRecvList = proc;
+    } else {
+        proc->nextBlockRecv = after->nextBlockRecv;
+        after->nextBlockRecv = proc;
+    }
+    if (proc->nextBlockRecv == NULL) {
+        mbptr->blockRecvTail = proc;
+    } else {
+        proc->nextBlockRecv->prevBlockRecv = proc;
+    }
+    proc->waitMbox = mbptr->mboxID;
+    proc->blockType = RECV_BLOCK;
+    proc->timedOut = 0;
+}
+
+/*
+ *Takes a process off a mailbox's blocked send list, wherever it is, and
+ *cancels its timeout
+ */
+void removeFromBlockSendList(mailboxPtr mbptr, mboxProcPtr proc) {
+    if (proc->prevBlockSend == NULL) {
+        mbptr->blockSendList = proc->nextBlockSend;
+    } else {
+        proc->prevBlockSend->nextBlockSend = proc->nextBlockSend;
+    }
+    if (proc->nextBlockSend == NULL) {
+        mbptr->blockSendTail = proc->prevBlockSend;
+    } else {
+        proc->nextBlockSend->prevBlockSend = proc->prevBlockSend;
+    }
+    proc->nextBlockSend = NULL;
+    proc->prevBlockSend = NULL;
+    proc->waitMbox = -1;
+    removeTimer(proc);
+}
+
+/*
+ *Takes a process off a mailbox's blocked receive list, wherever it is,
+ *and cancels its timeout
+ */
+void removeFromBlockRecvList(mailboxPtr mbptr, mboxProcPtr proc) {
+    if (proc->prevBlockRecv == NULL) {
+        mbptr->blockRecvList = proc->nextBlockRecv;
+    } else {
+        proc->prevBlockRecv->nextBlockRecv = proc->nextBlockRecv;
+    }
+    if (proc->nextBlockRecv == NULL) {
+        mbptr->blockRecvTail = proc->prevBlockRecv;
+    } else {
+        proc->nextBlockRecv->prevBlockRecv = proc->prevBlockRecv;
+    }
+    proc->nextBlockRecv = NULL;
+    proc->prevBlockRecv = NULL;
+    proc->waitMbox = -1;
+    removeTimer(proc);
+}
+
+/*
+ *Puts a process that is about to block in the timer heap, to be woken by
+ *the clock handler timeout microseconds from now
+ */
+void addTimer(mboxProcPtr proc, int timeout) {
+    proc->deadline = USLOSS_Clock() + timeout;
+    proc->timerIndex = numTimers;
+    TimerHeap[numTimers++] = proc;
+    siftTimer(proc->timerIndex);
+}
+
+/*
+ *Takes a process out of the timer heap, if it is there
+ */
+void removeTimer(mboxProcPtr proc) {
+    int i = proc->timerIndex;
+
+    if (i < 0) {
+        return;
+    }
+    proc->timerIndex = -1;
+    if (i == --numTimers) {
+        return;
+    }
+    TimerHeap[i] = TimerHeap[numTimers];
+    TimerHeap[i]->timerIndex = i;
+    siftTimer(i);
+}
+
+/*
+ *Moves the timer at index i up or down the heap to its place
+ */
+void siftTimer(int i) {
+    mboxProcPtr proc = TimerHeap[i];
+
+    while (i > 0 && TimerHeap[(i - 1) / 2]->deadline > proc->deadline) {
+        TimerHeap[i] = TimerHeap[(i - 1) / 2];
+        TimerHeap[i]->timerIndex = i;
+        i = (i - 1) / 2;
+    }
+    while (2 * i + 1 < numTimers) {
+        int child = 2 * i + 1;
+        if (child + 1 < numTimers &&
+                TimerHeap[child + 1]->deadline < TimerHeap[child]->deadline) {
+            child++;
+        }
+        if (TimerHeap[child]->deadline >= proc->deadline) {
+            break;
+        }
+        TimerHeap[i] = TimerHeap[child];
+        TimerHeap[i]->timerIndex = i;
+        i = child;
+    }
+    TimerHeap[i] = proc;
+    proc->timerIndex = i;
+}
+
+/*
+ *Wakes every process whose timeout has run out, taking it off the list
+ *it was blocked on
+ */
+void expireTimers() {
+    int now = USLOSS_Clock();
+
+    while (numTimers > 0 && TimerHeap[0]->deadline <= now) {
+        mboxProcPtr proc = TimerHeap[0];
+        mailboxPtr mbptr = &MailBoxTable[proc->waitMbox];
+
+        if (proc->blockType == SEND_BLOCK) {
+            removeFromBlockSendList(mbptr, proc);
+        } else {
+            removeFromBlockRecvList(mbptr, proc);
+        }
+        proc->timedOut = 1;
+        unblockProc(proc->pid);
+        disableInterrupts();
+    }
+}
+
+/*
+ *Gives a device status to the process waiting on the device's mailbox,
+ *or keeps it in the device's ring for the next waitDevice. A process that
+ *blocked in MboxReceive or MboxReceiveAny while statuses were kept is
+ *given the oldest, and this one is kept, before the process can run.
+ */
+void postDeviceStatus(int deviceID, int status) {
+    mailboxPtr mbptr = &MailBoxTable[deviceID];
+    int oldest;
+
+    if (mbptr->blockRecvList != NULL || mbptr->selectList != NULL) {
+        if (takeDeviceStatus(deviceID, &oldest)) {
+            keepDeviceStatus(deviceID, status);
+            status = oldest;
+        }
+        MboxCondSend(deviceID, &status, sizeof(int));
+    } else {
+        keepDeviceStatus(deviceID, status);
+    }
+}
+
+/*
+ *Keeps a device status in the device's ring. A clock status replaces one
+ *that has not been taken yet, as only the latest matters.
+ */
+void keepDeviceStatus(int deviceID, int status) {
+    devRing *ring = &DeviceRings[deviceID];
+
+    if (deviceID == CLOCK_MBOX && ring->head != ring->tail) {
+        ring->status[(ring->tail - 1) % DEVRING_SIZE] = status;
+        ring->coalesced++;
+    } else if (ring->tail - ring->head == DEVRING_SIZE) {
+        ring->overflows++;
+    } else {
+        ring->status[ring->tail++ % DEVRING_SIZE] = status;
+    }
+}
+
+/*
+ *Takes the oldest status from a device's ring; returns 0 if it is empty
+ */
+int takeDeviceStatus(int deviceID, int *status) {
+    devRing *ring = &DeviceRings[deviceID];
+
+    if (ring->head == ring->tail) {
+        return 0;
+    }
+    *status = ring->status[ring->head++ % DEVRING_SIZE];
+    return 1;
+}
+
+/*
+ *Frees the oldest messages of a broadcast mailbox that every subscriber
+ *has read, and wakes a publisher waiting for room for each one freed, or
+ *all of them once there are no subscribers
+ */
+void trimBroadcast(mailboxPtr mbptr) {
+    int pids[MAXPROC];  // blocked publishers to wake
+    int numPids = 0;
+    int freed = 0;
+
+    while (mbptr->slotList != NULL && mbptr->slotList->refs <= 0) {
+        slotPtr slotptr = mbptr->slotList;
+        removeFirstSlot(mbptr);
+        freeSlot(slotptr->slotID);
+        mbptr->slotsUsed--;
+        freed++;
+    }
+    while (mbptr->blockSendList != NULL &&
+            (numPids < freed || mbptr->numSubs == 0)) {
+        pids[numPids++] = mbptr->blockSendList->pid;
+        removeFromBlockSendList(mbptr, mbptr->blockSendList);
+    }
+#ifdef OWN_PHASE1
+    unblockMany(pids, numPids);
+    disableInterrupts();
+#else
+    for (int i = 0; i < numPids; i++) {
+        unblockProc(pids[i]);
+        disableInterrupts();
+    }
+#endif
+}
+
+/*
+ *Drops the oldest message of a full BCAST_OVERWRITE mailbox, moving the
+ *subscribers that had not read it past it
+ */
+void dropOldest(mailboxPtr mbptr) {
+    slotPtr slotptr = mbptr->slotList;
+
+    for (bcastSub *sub = mbptr->subList; sub != NULL; sub = sub->nextSub) {
+        if (sub->nextSeq <= slotptr->seq) {
+            sub->nextSeq = slotptr->seq + 1;
+            sub->missed++;
+        }
+    }
+    removeFirstSlot(mbptr);
+    freeSlot(slotptr->slotID);
+    mbptr->slotsUsed--;
+}
+
+/*
+ *Frees the subscribers of a broadcast mailbox being released. Puts the
+ *pids of those blocked in MboxReceiveSub in pids, marked released, and
+ *returns how many there are.
+ */
+int releaseSubscribers(mailboxPtr mbptr, int pids[]) {
+    int numPids = 0;
+
+    while (mbptr->subList != NULL) {
+        bcastSub *sub = mbptr->subList;
+        mbptr->subList = sub->nextSub;
+        if (sub->waiter != -1) {
+            MboxProcTable[sub->waiter % MAXPROC].mboxReleased = 1;
+            pids[numPids++] = sub->waiter;
+        }
+        sub->mboxID = -1;
+        sub->waiter = -1;
+        sub->nextSub = FreeSubs;
+        FreeSubs = sub;
+    }
+    mbptr->numSubs = 0;
+    return numPids;
+}
+
+/*
+ *Moves the oldest MboxReceiveAny caller waiting on the mailbox onto its
+ *blocked receive list, if no other receiver is there, so that the sender
+ *hands it the message. Its other select nodes are cancelled.
+ */
+void claimSelector(mailboxPtr mbptr) {
+    if (mbptr->blockRecvList != NULL || mbptr->selectList == NULL) {
+        return;
+    }
+    mboxProcPtr proc = mbptr->selectList->proc;
+    cancelSelect(proc);
+    proc->selectMbox = mbptr->mboxID;
+    mbptr->lastReceiver = proc->pid;
+    addToBlockRecvList(mbptr, proc);
+}
+
+/*
+ *Takes the select nodes of an MboxReceiveAny caller off their mailboxes
+ */
+void cancelSelect(mboxProcPtr proc) {
+    selectNodePtr nodes = SelectNodes[proc->pid % MAXPROC];
+
+    for (int i = 0; i < proc->numSelect; i++) {
+        mailboxPtr mbptr = &MailBoxTable[nodes[i].mboxID];
+
+        if (nodes[i].prev == NULL) {
+            mbptr->selectList = nodes[i].next;
+        } else {
+            nodes[i].prev->next = nodes[i].next;
+        }
+        if (nodes[i].next == NULL) {
+            mbptr->selectTail = nodes[i].prev;
+        } else {
+            nodes[i].next->prev = nodes[i].prev;
+        }
+    }
+    proc->numSelect = 0;
 }
@@ -11,6 +11,29 @@
 #define MAXMBOX         2000
 #define MAXSLOTS        2500
 #define MAX_MESSAGE     150  // largest possible message in a single slot
+#define MAXSUBSCRIBERS  200  // subscribers of all broadcast mailboxes
+
+// what MboxPublish does when a broadcast mailbox is full: drop the oldest
+// message, or block until every subscriber has read it
+#define BCAST_OVERWRITE 1
+#define BCAST_BLOCK     2
+
+// message priorities for MboxSendPriority, 0 the most urgent; the other
+// sends use MSG_PRIO_DEFAULT
+#define NUMMSGPRIOS      8
+#define MSG_PRIO_DEFAULT 4
+
+// system calls added by phase 2, past the USLOSS ones
+#define SYS_MBOXSENDMANY     31
+#define SYS_MBOXRECEIVEMANY  32
+#define SYS_SYSCALLSTATS     33
+#define SYS_RINGENTER        34
+
+// entries in each of the submission and completion rings, a power of two
+#define RING_ENTRIES         32
+
+// log2 latency buckets kept for each system call
+#define SYSSTAT_BUCKETS      24
 
 // returns id of mailbox, or -1 if no more mailboxes, -2 if invalid args
 extern int MboxCreate(int slots, int slot_size);
@@ -30,10 +53,85 @@ extern int MboxCondSend(int mbox_id, void *msg_ptr, int msg_size);
 // returns 0 if successful, 1 if no msg available, -1 if illegal args
 extern int MboxCondReceive(int mbox_id, void *msg_ptr, int msg_max_size);
 
+// as MboxSend and MboxReceive, but give up after timeout microseconds
+// (> 0), give or take a clock interrupt; return -2 if the time ran out
+extern int MboxSendTimed(int mbox_id, void *msg_ptr, int msg_size,
+                         int timeout);
+extern int MboxReceiveTimed(int mbox_id, void *msg_ptr, int msg_max_size,
+                            int timeout);
+
+// receives from whichever of the count mailboxes in mbox_ids gets a msg
+// first and sets *which to its id; returns as MboxReceive
+extern int MboxReceiveAny(int mbox_ids[], int count, void *msg_ptr,
+                          int msg_max_size, int *which);
+
+// sends msgs[i] of sizes[i] bytes in order, blocking only until the first
+// is sent; returns # of msgs sent, -1 if illegal args, -3 if zapped or
+// the mailbox was released before any was sent
+extern int MboxSendMany(int mbox_id, void *msgs[], int sizes[], int count);
+
+// receives into msgs[i] of at most sizes[i] bytes, blocking only until
+// the first arrives; sets sizes[i] to the size received; returns # of
+// msgs received, or -1 or -3 as for MboxSendMany
+extern int MboxReceiveMany(int mbox_id, void *msgs[], int sizes[],
+                           int count);
+
+// returns a kernel buffer of size bytes for MboxSendRef, or NULL
+extern void *MboxAllocBuf(int size);
+
+// returns 0 if successful, -1 if buf is not an allocated buffer
+extern int MboxFreeBuf(void *buf);
+
+// hands buf to the mailbox without copying; returns 0 if successful,
+// -1 if illegal args, -3 if zapped or the mailbox was released
+extern int MboxSendRef(int mbox_id, void *buf, int msg_size);
+
+// sets *buf to a received buffer, which the caller must MboxFreeBuf;
+// returns size of msg if successful, -1 if illegal args, -3 as above
+extern int MboxReceiveRef(int mbox_id, void **buf);
+
+// returns id of a mailbox whose msgs, and blocked senders, are kept in
+// priority order, FIFO within a priority; -1 if no more mailboxes
+extern int MboxCreatePriority(int slots, int slot_size);
+
+// as MboxSend, with a priority from 0 (most urgent) to NUMMSGPRIOS - 1;
+// the priority only matters to a mailbox from MboxCreatePriority
+extern int MboxSendPriority(int mbox_id, void *msg_ptr, int msg_size,
+                            int priority);
+
+// returns id of a broadcast mailbox that keeps up to slots msgs, with
+// policy BCAST_OVERWRITE or BCAST_BLOCK; -1 if no more mailboxes
+extern int MboxCreateBroadcast(int slots, int slot_size, int policy);
+
+// returns id of a new subscriber that gets every msg published from now
+// on, -1 if invalid args or no more subscribers
+extern int MboxSubscribe(int mbox_id);
+
+// returns 0 if successful, -1 if invalid arg or a process is receiving
+extern int MboxUnsubscribe(int sub_id);
+
+// keeps one copy of msg for every subscriber; returns 0 if successful,
+// -1 if invalid args, -3 if zapped or the mailbox was released
+extern int MboxPublish(int mbox_id, void *msg_ptr, int msg_size);
+
+// returns size of the subscriber's next msg, -1 if invalid args or the
+// msg is too big, -3 if zapped or the mailbox was released
+extern int MboxReceiveSub(int sub_id, void *msg_ptr, int msg_max_size);
+
+// msgs published but not yet read by the subscriber, and msgs it missed
+// to BCAST_OVERWRITE; returns -1 if invalid arg
+extern int MboxSubStats(int sub_id, int *pending, int *missed);
+
 // type = interrupt device type, unit = # of device (when more than one),
 // status = where interrupt handler puts device's status register.
 extern int waitDevice(int type, int unit, int *status);
 
+// statuses a device unit has waiting for waitDevice, clock statuses
+// replaced by newer ones, and statuses lost with its ring full; returns
+// -1 if invalid device or unit
+extern int deviceStats(int type, int unit, int *queued, int *coalesced,
+                       int *overflows);
+
 //  The systemArgs structure
 typedef struct systemArgs
 {
@@ -45,6 +143,56 @@ typedef struct systemArgs
         void *arg5;
 } systemArgs;
 
+// A batch of system calls for SYS_RINGENTER. The caller puts entries in
+// sq at sqTail and moves sqTail on; the kernel runs them in order from
+// sqHead, and puts each one, with its results, in cq at cqTail. The
+// caller reads completions from cqHead. Indexes only grow, and are taken
+// mod RING_ENTRIES.
+typedef struct ringEntry
+{
+        systemArgs args;
+        long userData;      // copied to the completion as is
+} ringEntry;
+
+typedef struct sysRing
+{
+        unsigned int sqHead;
+        unsigned int sqTail;
+        unsigned int cqHead;
+        unsigned int cqTail;
+        ringEntry sq[RING_ENTRIES];
+        ringEntry cq[RING_ENTRIES];
+} sysRing;
+
+// What syscallHandler has counted for one system call number. Times are
+// microseconds by USLOSS_Clock(), including any time spent blocked, for
+// the calls that have returned.
+typedef struct syscallStats
+{
+        int calls;
+        int returned;       // calls that have returned, and been timed
+        int errors;         // calls that left a negative result in arg4
+        long long totalTime;
+        int minTime;
+        int maxTime;
+        int buckets[SYSSTAT_BUCKETS]; // [0] is 0, [i] is 2^(i-1) to 2^i - 1
+} syscallStats;
+
+// copies the counters for system call number into *stats; returns 0 if
+// successful, -1 if invalid number
+extern int getSyscallStats(int number, syscallStats *stats);
+
+// prints the counters of every system call that has been made
+extern void dumpSyscallStats(void);
+
+// times the system call the current process is making; a handler that
+// sets user mode calls it first, as USLOSS_Clock traps in user mode
+extern void syscallDone(void);
+
+// runs up to count submitted entries of ring; returns # run, -1 if
+// invalid args
+extern int ringEnter(sysRing *ring, int count);
+
 // 
 extern void (*systemCallVec[])(systemArgs *args);
 
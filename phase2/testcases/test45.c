@@ -0,0 +1,47 @@
+/* Fills a mailbox with 2000 messages and releases it without receiving
+ * them, three times. That is more messages than MAXSLOTS, so the release
+ * has to return the slots. Also checks that the lowest free mailbox id
+ * is reused after a release, and that messages come out in order.
+ */
+
+#include <phase1.h>
+#include <phase2.h>
+#include <usloss.h>
+#include <stdio.h>
+
+#define NUMMSGS 2000
+
+int start2(char *arg)
+{
+    int mbox, first, second, result;
+    int msg;
+
+    USLOSS_Console("start2(): started\n");
+    for (int round = 0; round < 3; round++) {
+        mbox = MboxCreate(NUMMSGS, sizeof(int));
+        for (int i = 0; i < NUMMSGS; i++) {
+            result = MboxCondSend(mbox, &i, sizeof(int));
+            if (result != 0) {
+                USLOSS_Console("start2(): send %d returned %d\n", i, result);
+                break;
+            }
+        }
+        MboxReceive(mbox, &msg, sizeof(int));
+        USLOSS_Console("start2(): round %d, mailbox %d, first message %d\n",
+                       round, mbox, msg);
+        MboxReceive(mbox, &msg, sizeof(int));
+        USLOSS_Console("start2(): round %d, second message %d\n", round,
+                       msg);
+        MboxRelease(mbox);
+    }
+
+    first = MboxCreate(1, sizeof(int));
+    second = MboxCreate(1, sizeof(int));
+    USLOSS_Console("start2(): created mailboxes %d and %d\n", first, second);
+    MboxRelease(first);
+    USLOSS_Console("start2(): released %d, next MboxCreate returned %d\n",
+                   first, MboxCreate(1, sizeof(int)));
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
@@ -0,0 +1,75 @@
+/* Fills a mailbox with MAX_MESSAGE byte messages using conditional send
+ * until it returns -2. The byte budget for message storage holds a
+ * largest message in every slot, so the mailbox takes all MAXSLOTS of
+ * them before it is full. After one is received the freed slot takes a
+ * small message. Releasing the mailbox frees all of its space.
+ *
+ * Buffers from MboxAllocBuf then use up the budget on their own. A send
+ * returns -2 with slots to spare, until one buffer is freed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include <phase2.h>
+
+char big[MAX_MESSAGE];
+void *bufs[MAXSLOTS + 1];
+
+int start2(char *arg)
+{
+    int mbox, sent, numBufs, result;
+    int small = 42;
+
+    USLOSS_Console("start2(): started\n");
+    mbox = MboxCreate(MAXSLOTS, MAX_MESSAGE);
+
+    memset(big, 'x', sizeof(big));
+    for (sent = 0; sent < MAXSLOTS; sent++) {
+        result = MboxCondSend(mbox, big, sizeof(big));
+        if (result != 0) {
+            break;
+        }
+    }
+    USLOSS_Console("start2(): sent %d large messages, %s MAXSLOTS\n", sent,
+                   sent < MAXSLOTS ? "fewer than" : "as many as");
+    result = MboxCondSend(mbox, &small, sizeof(small));
+    USLOSS_Console("start2(): MboxCondSend to the full mailbox returned "
+                   "%d\n", result);
+
+    result = MboxReceive(mbox, big, sizeof(big));
+    USLOSS_Console("start2(): received %d bytes\n", result);
+    result = MboxCondSend(mbox, &small, sizeof(small));
+    USLOSS_Console("start2(): small send into the freed slot returned %d\n",
+                   result);
+
+    MboxRelease(mbox);
+    mbox = MboxCreate(10, sizeof(int));
+    result = MboxCondSend(mbox, &small, sizeof(small));
+    USLOSS_Console("start2(): send after release returned %d\n", result);
+    result = MboxCondReceive(mbox, &small, sizeof(small));
+    USLOSS_Console("start2(): received %d bytes, message %d\n", result,
+                   small);
+
+    for (numBufs = 0; numBufs <= MAXSLOTS; numBufs++) {
+        bufs[numBufs] = MboxAllocBuf(100);
+        if (bufs[numBufs] == NULL) {
+            break;
+        }
+    }
+    USLOSS_Console("start2(): MboxAllocBuf ran out after %d buffers\n",
+                   numBufs);
+    result = MboxCondSend(mbox, &small, sizeof(small));
+    USLOSS_Console("start2(): send with no room left returned %d\n", result);
+    MboxFreeBuf(bufs[--numBufs]);
+    result = MboxCondSend(mbox, &small, sizeof(small));
+    USLOSS_Console("start2(): send after freeing a buffer returned %d\n",
+                   result);
+    while (numBufs > 0) {
+        MboxFreeBuf(bufs[--numBufs]);
+    }
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
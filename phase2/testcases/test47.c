@@ -0,0 +1,118 @@
+/* Tests MboxSendRef and MboxReceiveRef.
+ *
+ * A buffer sent with MboxSendRef and received with MboxReceiveRef is the
+ * same buffer, not a copy. MboxReceive copies a sent buffer out and frees
+ * it, and MboxReceiveRef of a plain message gets a new buffer. start2
+ * blocks in MboxReceiveRef and gets the buffer Handoff sends directly.
+ * Sender fills the mailbox, wakes start2 and blocks in MboxSendRef until
+ * start2 receives. Zero-slot mailboxes, foreign buffers and freed
+ * buffers are rejected.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include <phase2.h>
+
+int Handoff(char *);
+int Sender(char *);
+
+int mbox, syncBox;
+char *sentBuf;
+
+int start2(char *arg)
+{
+    int status, result, zeroSlot;
+    char *buf, *received;
+    char plain[50];
+
+    USLOSS_Console("start2(): started\n");
+    mbox = MboxCreate(1, 50);
+    syncBox = MboxCreate(1, 0);
+
+    buf = MboxAllocBuf(50);
+    strcpy(buf, "by reference");
+    result = MboxSendRef(mbox, buf, strlen(buf) + 1);
+    USLOSS_Console("start2(): MboxSendRef returned %d\n", result);
+    result = MboxReceiveRef(mbox, (void **) &received);
+    USLOSS_Console("start2(): MboxReceiveRef returned %d, '%s', %s buffer\n",
+                   result, received, received == buf ? "same" : "another");
+    USLOSS_Console("start2(): MboxFreeBuf returned %d\n",
+                   MboxFreeBuf(received));
+    USLOSS_Console("start2(): MboxFreeBuf again returned %d\n",
+                   MboxFreeBuf(received));
+
+    buf = MboxAllocBuf(50);
+    strcpy(buf, "copied out");
+    MboxSendRef(mbox, buf, strlen(buf) + 1);
+    result = MboxReceive(mbox, plain, sizeof(plain));
+    USLOSS_Console("start2(): MboxReceive returned %d, '%s'\n", result,
+                   plain);
+
+    MboxSend(mbox, "copied in", strlen("copied in") + 1);
+    result = MboxReceiveRef(mbox, (void **) &received);
+    USLOSS_Console("start2(): MboxReceiveRef of a plain message returned "
+                   "%d, '%s'\n", result, received);
+    MboxFreeBuf(received);
+
+    fork1("Handoff", Handoff, NULL, 2 * USLOSS_MIN_STACK, 2);
+    USLOSS_Console("start2(): blocking in MboxReceiveRef\n");
+    result = MboxReceiveRef(mbox, (void **) &received);
+    USLOSS_Console("start2(): got %d bytes, '%s', %s buffer\n", result,
+                   received, received == sentBuf ? "Handoff's" : "another");
+    MboxFreeBuf(received);
+    join(&status);
+
+    fork1("Sender", Sender, NULL, 2 * USLOSS_MIN_STACK, 1);
+    MboxReceive(syncBox, NULL, 0);
+    for (int i = 0; i < 2; i++) {
+        result = MboxReceiveRef(mbox, (void **) &received);
+        USLOSS_Console("start2(): received '%s'%s\n", received,
+                       received == sentBuf ? ", Sender's buffer" : "");
+        MboxFreeBuf(received);
+    }
+    join(&status);
+
+    zeroSlot = MboxCreate(0, 50);
+    buf = MboxAllocBuf(10);
+    USLOSS_Console("start2(): MboxSendRef to zero-slot mailbox returned "
+                   "%d\n", MboxSendRef(zeroSlot, buf, 10));
+    USLOSS_Console("start2(): MboxSendRef of a plain buffer returned %d\n",
+                   MboxSendRef(mbox, plain, 10));
+    USLOSS_Console("start2(): MboxSendRef larger than the buffer returned "
+                   "%d\n", MboxSendRef(mbox, buf, 11));
+    MboxFreeBuf(buf);
+    USLOSS_Console("start2(): MboxSendRef of a freed buffer returned %d\n",
+                   MboxSendRef(mbox, buf, 10));
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
+
+int Handoff(char *arg)
+{
+    sentBuf = MboxAllocBuf(50);
+    strcpy(sentBuf, "to a blocked receiver");
+    USLOSS_Console("Handoff(): sending\n");
+    MboxSendRef(mbox, sentBuf, strlen(sentBuf) + 1);
+    quit(1);
+    return 0;
+}
+
+int Sender(char *arg)
+{
+    char *buf = MboxAllocBuf(50);
+
+    strcpy(buf, "first");
+    MboxSendRef(mbox, buf, strlen(buf) + 1);
+    MboxSend(syncBox, NULL, 0);
+
+    sentBuf = MboxAllocBuf(50);
+    strcpy(sentBuf, "second");
+    USLOSS_Console("Sender(): blocking in MboxSendRef\n");
+    MboxSendRef(mbox, sentBuf, strlen(sentBuf) + 1);
+    USLOSS_Console("Sender(): sent\n");
+    quit(2);
+    return 0;
+}
@@ -0,0 +1,158 @@
+/* Tests MboxSendMany and MboxReceiveMany, called directly and through
+ * their system calls.
+ *
+ * A batch of 5 sent to a 3-slot mailbox stops after 3, and a batch
+ * receive gets those 3. UserProc, in user mode, makes the same calls
+ * through SYS_MBOXSENDMANY and SYS_MBOXRECEIVEMANY; its batch receive
+ * stops at a message too big for its buffer, which stays in the mailbox.
+ * The test installs a SYS_TERMINATE handler so UserProc can quit.
+ * start2 then blocks in MboxReceiveMany and is woken by the first message
+ * of Producer's batch, so it gets only that one; the rest of the batch
+ * goes to slots.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include <phase2.h>
+#include <usyscall.h>
+
+#define BATCH 5
+
+int Producer(char *);
+int UserProc(char *);
+void terminate(systemArgs *);
+
+extern void USLOSS_Syscall(void *arg);
+
+int mbox;
+char *words[BATCH] = {"one", "two", "three", "four", "five"};
+
+int start2(char *arg)
+{
+    char bufs[BATCH][20];
+    void *msgs[BATCH];
+    int sizes[BATCH];
+    int result, status;
+
+    USLOSS_Console("start2(): started\n");
+    mbox = MboxCreate(3, 20);
+    systemCallVec[SYS_TERMINATE] = terminate;
+
+    for (int i = 0; i < BATCH; i++) {
+        msgs[i] = words[i];
+        sizes[i] = strlen(words[i]) + 1;
+    }
+    result = MboxSendMany(mbox, msgs, sizes, BATCH);
+    USLOSS_Console("start2(): MboxSendMany of %d returned %d\n", BATCH,
+                   result);
+
+    for (int i = 0; i < BATCH; i++) {
+        msgs[i] = bufs[i];
+        sizes[i] = sizeof(bufs[i]);
+    }
+    result = MboxReceiveMany(mbox, msgs, sizes, BATCH);
+    USLOSS_Console("start2(): MboxReceiveMany returned %d:", result);
+    for (int i = 0; i < result; i++) {
+        USLOSS_Console(" '%s' (%d)", bufs[i], sizes[i]);
+    }
+    USLOSS_Console("\n");
+
+    // the same through the system calls, from user mode
+    fork1("UserProc", UserProc, NULL, 2 * USLOSS_MIN_STACK, 1);
+    join(&status);
+
+    // a blocked batch receive is woken by the first message
+    fork1("Producer", Producer, NULL, 2 * USLOSS_MIN_STACK, 2);
+    for (int i = 0; i < BATCH; i++) {
+        msgs[i] = bufs[i];
+        sizes[i] = sizeof(bufs[i]);
+    }
+    USLOSS_Console("start2(): blocking in MboxReceiveMany\n");
+    result = MboxReceiveMany(mbox, msgs, sizes, BATCH);
+    USLOSS_Console("start2(): MboxReceiveMany returned %d: '%s'\n", result,
+                   bufs[0]);
+    join(&status);
+    result = MboxReceiveMany(mbox, msgs, sizes, BATCH);
+    USLOSS_Console("start2(): MboxReceiveMany returned %d:", result);
+    for (int i = 0; i < result; i++) {
+        USLOSS_Console(" '%s'", bufs[i]);
+    }
+    USLOSS_Console("\n");
+
+    USLOSS_Console("start2(): MboxSendMany with a negative count returned "
+                   "%d\n", MboxSendMany(mbox, msgs, sizes, -1));
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
+
+int Producer(char *arg)
+{
+    void *msgs[4];
+    int sizes[4];
+    int result;
+
+    for (int i = 0; i < 4; i++) {
+        msgs[i] = words[i];
+        sizes[i] = strlen(words[i]) + 1;
+    }
+    USLOSS_Console("Producer(): sending a batch of 4\n");
+    result = MboxSendMany(mbox, msgs, sizes, 4);
+    USLOSS_Console("Producer(): MboxSendMany returned %d\n", result);
+    quit(1);
+    return 0;
+}
+
+int UserProc(char *arg)
+{
+    char bufs[2][20];
+    void *msgs[2];
+    int sizes[2];
+    int result;
+    systemArgs args;
+
+    USLOSS_PsrSet(USLOSS_PsrGet() & ~USLOSS_PSR_CURRENT_MODE);
+    for (int i = 0; i < 2; i++) {
+        msgs[i] = words[i + 3];
+        sizes[i] = strlen(words[i + 3]) + 1;
+    }
+    args.number = SYS_MBOXSENDMANY;
+    args.arg1 = (void *) (long) mbox;
+    args.arg2 = msgs;
+    args.arg3 = sizes;
+    args.arg4 = (void *) 2L;
+    USLOSS_Syscall(&args);
+    USLOSS_Console("UserProc(): SYS_MBOXSENDMANY of 2 returned %d\n",
+                   (int) (long) args.arg4);
+
+    for (int i = 0; i < 2; i++) {
+        msgs[i] = bufs[i];
+    }
+    sizes[0] = sizeof(bufs[0]);
+    sizes[1] = 2;
+    args.number = SYS_MBOXRECEIVEMANY;
+    args.arg4 = (void *) 2L;
+    USLOSS_Syscall(&args);
+    USLOSS_Console("UserProc(): SYS_MBOXRECEIVEMANY with a 2 byte second "
+                   "buffer returned %d: '%s'\n", (int) (long) args.arg4,
+                   bufs[0]);
+
+    sizes[0] = sizeof(bufs[1]);
+    msgs[0] = bufs[1];
+    args.arg4 = (void *) 1L;
+    USLOSS_Syscall(&args);
+    result = (int) (long) args.arg4;
+    USLOSS_Console("UserProc(): then got %d: '%s'\n", result, bufs[1]);
+
+    args.number = SYS_TERMINATE;
+    args.arg1 = (void *) 3L;
+    USLOSS_Syscall(&args);
+    return 0;
+}
+
+/* kernel side of SYS_TERMINATE, so UserProc can quit */
+void terminate(systemArgs *args)
+{
+    quit((int) (long) args->arg1);
+}
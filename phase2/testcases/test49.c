@@ -0,0 +1,156 @@
+/* MboxReceiveAny and the timed sends and receives.
+ * Selector waits on a mailbox with slots and a zero-slot mailbox at once,
+ * and gets messages sent to either, then -3 when one is released. Then
+ * start2 times out in MboxReceiveTimed and MboxSendTimed, and gets a
+ * message that comes before its timeout. Last, a conditional send from
+ * BigSender too big for SmallSelector's buffer fails and leaves it
+ * waiting on both of its mailboxes.
+ */
+
+#include <phase1.h>
+#include <phase2.h>
+#include <usloss.h>
+#include <stdio.h>
+
+int Selector(char *);
+int Sender(char *);
+int LateSender(char *);
+int SmallSelector(char *);
+int BigSender(char *);
+
+int slotBox, zeroBox, fullBox;
+
+int start2(char *arg)
+{
+    int boxes[3];
+    int which, result, status;
+    char buf[20];
+
+    USLOSS_Console("start2(): started\n");
+    slotBox = MboxCreate(2, sizeof(buf));
+    zeroBox = MboxCreate(0, sizeof(buf));
+    fullBox = MboxCreate(2, sizeof(buf));
+
+    boxes[0] = slotBox;
+    boxes[1] = zeroBox;
+    boxes[2] = fullBox;
+    MboxCondSend(fullBox, "waiting", 8);
+    result = MboxReceiveAny(boxes, 3, buf, sizeof(buf), &which);
+    USLOSS_Console("start2(): MboxReceiveAny returned %d from mailbox %d: "
+                   "%s\n", result, which, buf);
+
+    fork1("Selector", Selector, NULL, 2 * USLOSS_MIN_STACK, 2);
+    fork1("Sender", Sender, NULL, 2 * USLOSS_MIN_STACK, 3);
+    join(&status);
+    join(&status);
+
+    result = MboxReceiveTimed(slotBox, buf, sizeof(buf), 200000);
+    USLOSS_Console("start2(): MboxReceiveTimed on empty mailbox returned "
+                   "%d\n", result);
+
+    MboxCondSend(fullBox, "one", 4);
+    MboxCondSend(fullBox, "two", 4);
+    result = MboxSendTimed(fullBox, "three", 6, 200000);
+    USLOSS_Console("start2(): MboxSendTimed on full mailbox returned %d\n",
+                   result);
+    while (MboxCondReceive(fullBox, buf, sizeof(buf)) >= 0) {
+        USLOSS_Console("start2(): full mailbox had %s\n", buf);
+    }
+
+    fork1("LateSender", LateSender, NULL, 2 * USLOSS_MIN_STACK, 3);
+    result = MboxReceiveTimed(slotBox, buf, sizeof(buf), 100000000);
+    USLOSS_Console("start2(): MboxReceiveTimed returned %d: %s\n", result,
+                   buf);
+    join(&status);
+
+    result = MboxReceiveTimed(slotBox, buf, sizeof(buf), 200000);
+    USLOSS_Console("start2(): MboxReceiveTimed on empty mailbox returned "
+                   "%d\n", result);
+
+    fork1("SmallSelector", SmallSelector, NULL, 2 * USLOSS_MIN_STACK, 2);
+    fork1("BigSender", BigSender, NULL, 2 * USLOSS_MIN_STACK, 3);
+    join(&status);
+    join(&status);
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
+
+int Selector(char *arg)
+{
+    int boxes[2];
+    int which, result;
+    char buf[20];
+
+    boxes[0] = slotBox;
+    boxes[1] = zeroBox;
+    for (int i = 0; i < 3; i++) {
+        USLOSS_Console("Selector(): waiting on both mailboxes\n");
+        result = MboxReceiveAny(boxes, 2, buf, sizeof(buf), &which);
+        if (result < 0) {
+            USLOSS_Console("Selector(): MboxReceiveAny returned %d\n",
+                           result);
+            break;
+        }
+        USLOSS_Console("Selector(): got %s from the %s mailbox\n", buf,
+                       which == zeroBox ? "zero-slot" : "slot");
+    }
+    quit(3);
+    return 0;
+} /* Selector */
+
+int Sender(char *arg)
+{
+    char buf[20];
+
+    USLOSS_Console("Sender(): sending to the zero-slot mailbox\n");
+    MboxSend(zeroBox, "hello", 6);
+    USLOSS_Console("Sender(): sending to the slot mailbox\n");
+    MboxSend(slotBox, "world", 6);
+    USLOSS_Console("Sender(): releasing the zero-slot mailbox\n");
+    MboxRelease(zeroBox);
+
+    // Selector's wait on slotBox must be gone, so this goes in a slot
+    MboxCondSend(slotBox, "left", 5);
+    MboxCondReceive(slotBox, buf, sizeof(buf));
+    USLOSS_Console("Sender(): slot mailbox had %s\n", buf);
+    quit(4);
+    return 0;
+} /* Sender */
+
+int LateSender(char *arg)
+{
+    USLOSS_Console("LateSender(): sending to the slot mailbox\n");
+    MboxSend(slotBox, "late", 5);
+    quit(5);
+    return 0;
+} /* LateSender */
+
+int SmallSelector(char *arg)
+{
+    int boxes[2];
+    int which, result;
+    char buf[4];
+
+    boxes[0] = slotBox;
+    boxes[1] = fullBox;
+    result = MboxReceiveAny(boxes, 2, buf, sizeof(buf), &which);
+    USLOSS_Console("SmallSelector(): got %d bytes from the %s mailbox: %s\n",
+                   result, which == fullBox ? "full" : "slot", buf);
+    quit(6);
+    return 0;
+} /* SmallSelector */
+
+int BigSender(char *arg)
+{
+    int result;
+
+    result = MboxCondSend(slotBox, "too long", 9);
+    USLOSS_Console("BigSender(): MboxCondSend too big for SmallSelector "
+                   "returned %d\n", result);
+    result = MboxCondSend(fullBox, "ok", 3);
+    USLOSS_Console("BigSender(): MboxCondSend to its other mailbox returned "
+                   "%d\n", result);
+    quit(7);
+    return 0;
+} /* BigSender */
@@ -0,0 +1,64 @@
+/* A clock status that comes while no process is in waitDevice is kept
+ * for the next waitDevice instead of being dropped. Newer clock statuses
+ * replace it and are counted as coalesced.
+ *
+ * MboxReceiveAny and MboxReceive on the clock mailbox, called while a
+ * status is kept, get it with the next clock interrupt, which keeps its
+ * own status in its place.
+ */
+
+#include <phase1.h>
+#include <phase2.h>
+#include <usloss.h>
+#include <stdio.h>
+
+int start2(char *arg)
+{
+    int status, result;
+    int queued, coalesced, overflows, which;
+    int boxes[2];
+
+    USLOSS_Console("start2(): started, calling waitDevice for clock\n");
+    waitDevice(USLOSS_CLOCK_DEV, 0, &status);
+    deviceStats(USLOSS_CLOCK_DEV, 0, &queued, &coalesced, &overflows);
+    USLOSS_Console("start2(): queued = %d, coalesced = %d\n", queued,
+                   coalesced);
+
+    // stay busy until a second clock status replaces a first one
+    do {
+        deviceStats(USLOSS_CLOCK_DEV, 0, &queued, &coalesced, &overflows);
+    } while (coalesced == 0);
+    USLOSS_Console("start2(): busy through two clock statuses, queued = %d\n",
+                   queued);
+
+    result = waitDevice(USLOSS_CLOCK_DEV, 0, &status);
+    deviceStats(USLOSS_CLOCK_DEV, 0, &queued, &coalesced, &overflows);
+    USLOSS_Console("start2(): waitDevice returned %d, queued = %d, "
+                   "overflows = %d\n", result, queued, overflows);
+
+    boxes[0] = 0;  // the clock mailbox
+    boxes[1] = MboxCreate(1, sizeof(int));
+    for (int i = 0; i < 2; i++) {
+        do {
+            deviceStats(USLOSS_CLOCK_DEV, 0, &queued, &coalesced, &overflows);
+        } while (queued == 0);
+        if (i == 0) {
+            result = MboxReceiveAny(boxes, 2, &status, sizeof(int), &which);
+            USLOSS_Console("start2(): MboxReceiveAny with a status kept "
+                           "returned %d from mailbox %d\n", result, which);
+        } else {
+            result = MboxReceive(boxes[0], &status, sizeof(int));
+            USLOSS_Console("start2(): MboxReceive with a status kept "
+                           "returned %d\n", result);
+        }
+        deviceStats(USLOSS_CLOCK_DEV, 0, &queued, &coalesced, &overflows);
+        USLOSS_Console("start2(): queued = %d\n", queued);
+    }
+
+    result = deviceStats(USLOSS_DISK_DEV, 2, &queued, &coalesced,
+                         &overflows);
+    USLOSS_Console("start2(): deviceStats for disk 2 returned %d\n", result);
+
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
@@ -0,0 +1,122 @@
+/* Tests the counters syscallHandler keeps for each system call.
+ * UserProc, in user mode, makes one good and one bad SYS_MBOXSENDMANY
+ * call, then reads their counters through SYS_SYSCALLSTATS. start2 reads
+ * the counters of SYS_SYSCALLSTATS and SYS_TERMINATE with getSyscallStats.
+ * The test installs a SYS_TERMINATE handler so UserProc can quit, and a
+ * SYS_SEMV handler that, like phase3's, calls syscallDone and then sets
+ * user mode, so it is timed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include <phase2.h>
+#include <usyscall.h>
+
+int UserProc(char *);
+void terminate(systemArgs *);
+void userModeReturn(systemArgs *);
+void printStats(char *who, int number, syscallStats *stats);
+
+extern void USLOSS_Syscall(void *arg);
+
+int mbox;
+
+int start2(char *arg)
+{
+    syscallStats stats;
+    int status;
+
+    USLOSS_Console("start2(): started\n");
+    mbox = MboxCreate(3, 20);
+    systemCallVec[SYS_TERMINATE] = terminate;
+    systemCallVec[SYS_SEMV] = userModeReturn;
+
+    fork1("UserProc", UserProc, NULL, 2 * USLOSS_MIN_STACK, 1);
+    join(&status);
+
+    getSyscallStats(SYS_SYSCALLSTATS, &stats);
+    printStats("start2", SYS_SYSCALLSTATS, &stats);
+    getSyscallStats(SYS_TERMINATE, &stats);
+    printStats("start2", SYS_TERMINATE, &stats);
+    getSyscallStats(SYS_SEMV, &stats);
+    printStats("start2", SYS_SEMV, &stats);
+    USLOSS_Console("start2(): getSyscallStats(%d) returned %d\n",
+                   MAXSYSCALLS, getSyscallStats(MAXSYSCALLS, &stats));
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
+
+int UserProc(char *arg)
+{
+    void *msgs[1] = {"hello"};
+    int sizes[1] = {6};
+    syscallStats stats;
+    systemArgs args;
+
+    USLOSS_PsrSet(USLOSS_PsrGet() & ~USLOSS_PSR_CURRENT_MODE);
+    args.number = SYS_MBOXSENDMANY;
+    args.arg1 = (void *) (long) mbox;
+    args.arg2 = msgs;
+    args.arg3 = sizes;
+    args.arg4 = (void *) 1L;
+    USLOSS_Syscall(&args);
+    USLOSS_Console("UserProc(): SYS_MBOXSENDMANY returned %d\n",
+                   (int) (long) args.arg4);
+    args.arg1 = (void *) -1L;
+    args.arg4 = (void *) 1L;
+    USLOSS_Syscall(&args);
+    USLOSS_Console("UserProc(): SYS_MBOXSENDMANY to mailbox -1 returned "
+                   "%d\n", (int) (long) args.arg4);
+
+    args.number = SYS_SYSCALLSTATS;
+    args.arg1 = (void *) (long) SYS_MBOXSENDMANY;
+    args.arg2 = &stats;
+    USLOSS_Syscall(&args);
+    USLOSS_Console("UserProc(): SYS_SYSCALLSTATS returned %d\n",
+                   (int) (long) args.arg4);
+    printStats("UserProc", SYS_MBOXSENDMANY, &stats);
+
+    args.arg1 = (void *) -1L;
+    USLOSS_Syscall(&args);
+    USLOSS_Console("UserProc(): SYS_SYSCALLSTATS for -1 returned %d\n",
+                   (int) (long) args.arg4);
+
+    args.number = SYS_SEMV;
+    USLOSS_Syscall(&args);
+    USLOSS_Syscall(&args);
+
+    args.number = SYS_TERMINATE;
+    args.arg1 = (void *) 3L;
+    USLOSS_Syscall(&args);
+    return 0;
+}
+
+/* prints the counters that do not depend on how fast the calls were */
+void printStats(char *who, int number, syscallStats *stats)
+{
+    int inBuckets = 0;
+
+    for (int i = 0; i < SYSSTAT_BUCKETS; i++) {
+        inBuckets += stats->buckets[i];
+    }
+    USLOSS_Console("%s(): syscall %d: calls %d, returned %d, errors %d, "
+                   "in buckets %d, min <= max %d\n", who, number,
+                   stats->calls, stats->returned, stats->errors, inBuckets,
+                   stats->minTime <= stats->maxTime);
+}
+
+/* kernel side of SYS_TERMINATE, so UserProc can quit */
+void terminate(systemArgs *args)
+{
+    quit((int) (long) args->arg1);
+}
+
+/* returns in user mode, like a phase3 handler, timed by syscallDone */
+void userModeReturn(systemArgs *args)
+{
+    args->arg4 = (void *) 0L;
+    syscallDone();
+    USLOSS_PsrSet((USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT) & 14);
+}
@@ -0,0 +1,123 @@
+/* Tests SYS_RINGENTER. UserProc, in user mode, submits seven calls to a
+ * sysRing and runs them with one system call: a good and a bad
+ * SYS_MBOXSENDMANY, a call with an invalid number, a call with no
+ * handler, SYS_SYSCALLSTATS, and two calls whose handler sends to a
+ * mailbox and then sets user mode, as phase3 handlers do. It then reads
+ * their completions, in order, with their userData.
+ * The test installs a SYS_TERMINATE handler so UserProc can quit.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include <phase2.h>
+#include <usyscall.h>
+
+int UserProc(char *);
+void terminate(systemArgs *);
+void sendThenUserMode(systemArgs *);
+void submit(int number, void *arg1, void *arg2, void *arg3, void *arg4);
+
+extern void USLOSS_Syscall(void *arg);
+
+int mbox;
+sysRing ring;
+
+int start2(char *arg)
+{
+    syscallStats stats;
+    char buf[20];
+    int status, result;
+
+    USLOSS_Console("start2(): started\n");
+    mbox = MboxCreate(3, 20);
+    systemCallVec[SYS_TERMINATE] = terminate;
+    systemCallVec[SYS_SEMV] = sendThenUserMode;
+
+    fork1("UserProc", UserProc, NULL, 2 * USLOSS_MIN_STACK, 1);
+    join(&status);
+
+    while ((result = MboxCondReceive(mbox, buf, sizeof(buf))) >= 0) {
+        USLOSS_Console("start2(): mailbox had %d bytes: %s\n", result, buf);
+    }
+    getSyscallStats(SYS_RINGENTER, &stats);
+    USLOSS_Console("start2(): SYS_RINGENTER calls %d\n", stats.calls);
+    getSyscallStats(SYS_MBOXSENDMANY, &stats);
+    USLOSS_Console("start2(): SYS_MBOXSENDMANY calls %d, errors %d\n",
+                   stats.calls, stats.errors);
+    USLOSS_Console("start2(): ringEnter with a NULL ring returned %d\n",
+                   ringEnter(NULL, 1));
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
+
+int UserProc(char *arg)
+{
+    void *msgs[1] = {"hello"};
+    int sizes[1] = {6};
+    syscallStats stats;
+    systemArgs args;
+
+    USLOSS_PsrSet(USLOSS_PsrGet() & ~USLOSS_PSR_CURRENT_MODE);
+    submit(SYS_MBOXSENDMANY, (void *) (long) mbox, msgs, sizes, (void *) 1L);
+    submit(SYS_MBOXSENDMANY, (void *) -1L, msgs, sizes, (void *) 1L);
+    submit(MAXSYSCALLS, NULL, NULL, NULL, NULL);
+    submit(SYS_SEMP, NULL, NULL, NULL, NULL);
+    submit(SYS_SYSCALLSTATS, (void *) (long) SYS_MBOXSENDMANY, &stats, NULL,
+           NULL);
+    submit(SYS_SEMV, "first", NULL, NULL, NULL);
+    submit(SYS_SEMV, "second", NULL, NULL, NULL);
+
+    args.number = SYS_RINGENTER;
+    args.arg1 = &ring;
+    args.arg2 = (void *) 10L;
+    USLOSS_Syscall(&args);
+    USLOSS_Console("UserProc(): SYS_RINGENTER returned %d\n",
+                   (int) (long) args.arg4);
+    while (ring.cqHead != ring.cqTail) {
+        ringEntry *entry = &ring.cq[ring.cqHead++ % RING_ENTRIES];
+        USLOSS_Console("UserProc(): completion %ld: syscall %d, arg4 %d\n",
+                       entry->userData, entry->args.number,
+                       (int) (long) entry->args.arg4);
+    }
+    USLOSS_Console("UserProc(): SYS_MBOXSENDMANY calls %d, errors %d\n",
+                   stats.calls, stats.errors);
+
+    args.arg2 = (void *) 10L;
+    USLOSS_Syscall(&args);
+    USLOSS_Console("UserProc(): SYS_RINGENTER with nothing submitted "
+                   "returned %d\n", (int) (long) args.arg4);
+
+    args.number = SYS_TERMINATE;
+    args.arg1 = (void *) 3L;
+    USLOSS_Syscall(&args);
+    return 0;
+}
+
+/* puts a call in the submission ring, numbered by its place */
+void submit(int number, void *arg1, void *arg2, void *arg3, void *arg4)
+{
+    ringEntry *entry = &ring.sq[ring.sqTail % RING_ENTRIES];
+
+    entry->args.number = number;
+    entry->args.arg1 = arg1;
+    entry->args.arg2 = arg2;
+    entry->args.arg3 = arg3;
+    entry->args.arg4 = arg4;
+    entry->userData = ring.sqTail++;
+}
+
+/* kernel side of SYS_TERMINATE, so UserProc can quit */
+void terminate(systemArgs *args)
+{
+    quit((int) (long) args->arg1);
+}
+
+/* sends arg1 to mbox, then leaves user mode set like a phase3 handler */
+void sendThenUserMode(systemArgs *args)
+{
+    args->arg4 = (void *) (long) MboxCondSend(mbox, args->arg1,
+                                              strlen(args->arg1) + 1);
+    USLOSS_PsrSet(USLOSS_PsrGet() & 14);
+}
@@ -0,0 +1,175 @@
+/* Broadcast mailboxes. Two subscribers of a BCAST_OVERWRITE mailbox with
+ * 3 slots; the 4th message published drops the first. Two listeners get
+ * the same two messages from one publish each. On a 1-slot BCAST_BLOCK
+ * mailbox, Publisher blocks until Reader has read the message before;
+ * it runs again, and prints, before Reader prints that message. When
+ * the only subscriber of a full BCAST_BLOCK mailbox unsubscribes, both
+ * publishers blocked on it return.
+ * Releasing a broadcast mailbox wakes a subscriber waiting on it.
+ */
+
+#include <phase1.h>
+#include <phase2.h>
+#include <usloss.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int Listener(char *);
+int Publisher(char *);
+int Reader(char *);
+int Waiter(char *);
+int Releaser(char *);
+int CrowdPublisher(char *);
+int Leaver(char *);
+
+int fanBox, blockBox, blockSub, releaseBox, releaseSub, crowdBox, crowdSub;
+
+int start2(char *arg)
+{
+    char *words[4] = {"a", "b", "c", "d"};
+    char buf[20], subArg[10];
+    int box, s1, s2, pending, missed, result, status;
+
+    USLOSS_Console("start2(): started\n");
+    box = MboxCreateBroadcast(3, sizeof(buf), BCAST_OVERWRITE);
+    s1 = MboxSubscribe(box);
+    s2 = MboxSubscribe(box);
+    for (int i = 0; i < 4; i++) {
+        MboxPublish(box, words[i], 2);
+    }
+    MboxSubStats(s1, &pending, &missed);
+    USLOSS_Console("start2(): first subscriber has %d pending, missed %d\n",
+                   pending, missed);
+    while (MboxSubStats(s1, &pending, &missed) == 0 && pending > 0) {
+        MboxReceiveSub(s1, buf, sizeof(buf));
+        USLOSS_Console("start2(): first subscriber got %s\n", buf);
+    }
+    MboxSubStats(s2, &pending, &missed);
+    USLOSS_Console("start2(): second subscriber has %d pending, missed %d\n",
+                   pending, missed);
+    MboxUnsubscribe(s2);
+    MboxUnsubscribe(s1);
+    USLOSS_Console("start2(): MboxSend to a broadcast mailbox returned %d\n",
+                   MboxSend(box, "e", 2));
+    MboxRelease(box);
+
+    // one publish for every listener
+    fanBox = MboxCreateBroadcast(3, sizeof(buf), BCAST_OVERWRITE);
+    for (int i = 0; i < 2; i++) {
+        sprintf(subArg, "%d", MboxSubscribe(fanBox));
+        fork1(i == 0 ? "Listener1" : "Listener2", Listener, subArg,
+              2 * USLOSS_MIN_STACK, 2);
+    }
+    MboxPublish(fanBox, "config", 7);
+    MboxPublish(fanBox, "shutdown", 9);
+    join(&status);
+    join(&status);
+
+    // backpressure
+    blockBox = MboxCreateBroadcast(1, sizeof(buf), BCAST_BLOCK);
+    blockSub = MboxSubscribe(blockBox);
+    MboxPublish(blockBox, "x", 2);
+    fork1("Publisher", Publisher, NULL, 2 * USLOSS_MIN_STACK, 2);
+    fork1("Reader", Reader, NULL, 2 * USLOSS_MIN_STACK, 3);
+    join(&status);
+    join(&status);
+
+    // the last subscriber leaves with two publishers blocked
+    crowdBox = MboxCreateBroadcast(1, sizeof(buf), BCAST_BLOCK);
+    crowdSub = MboxSubscribe(crowdBox);
+    MboxPublish(crowdBox, "x", 2);
+    fork1("CrowdPublisher1", CrowdPublisher, "1", 2 * USLOSS_MIN_STACK, 2);
+    fork1("CrowdPublisher2", CrowdPublisher, "2", 2 * USLOSS_MIN_STACK, 2);
+    fork1("Leaver", Leaver, NULL, 2 * USLOSS_MIN_STACK, 3);
+    for (int i = 0; i < 3; i++) {
+        join(&status);
+    }
+    MboxRelease(crowdBox);
+
+    // release with a subscriber waiting
+    releaseBox = MboxCreateBroadcast(1, sizeof(buf), BCAST_BLOCK);
+    releaseSub = MboxSubscribe(releaseBox);
+    fork1("Waiter", Waiter, NULL, 2 * USLOSS_MIN_STACK, 2);
+    fork1("Releaser", Releaser, NULL, 2 * USLOSS_MIN_STACK, 3);
+    join(&status);
+    join(&status);
+
+    result = MboxPublish(MboxCreate(1, sizeof(buf)), "f", 2);
+    USLOSS_Console("start2(): MboxPublish to a plain mailbox returned %d\n",
+                   result);
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
+
+int Listener(char *arg)
+{
+    char buf[20];
+    int sub = atoi(arg);
+
+    do {
+        MboxReceiveSub(sub, buf, sizeof(buf));
+        USLOSS_Console("Listener(): subscriber %d got %s\n", sub, buf);
+    } while (strcmp(buf, "shutdown") != 0);
+    quit(1);
+    return 0;
+} /* Listener */
+
+int Publisher(char *arg)
+{
+    USLOSS_Console("Publisher(): publishing y to the full mailbox\n");
+    int result = MboxPublish(blockBox, "y", 2);
+    USLOSS_Console("Publisher(): MboxPublish returned %d\n", result);
+    quit(2);
+    return 0;
+} /* Publisher */
+
+int Reader(char *arg)
+{
+    char buf[20];
+
+    for (int i = 0; i < 2; i++) {
+        MboxReceiveSub(blockSub, buf, sizeof(buf));
+        USLOSS_Console("Reader(): got %s\n", buf);
+    }
+    quit(3);
+    return 0;
+} /* Reader */
+
+int Waiter(char *arg)
+{
+    char buf[20];
+
+    USLOSS_Console("Waiter(): waiting on the broadcast mailbox\n");
+    int result = MboxReceiveSub(releaseSub, buf, sizeof(buf));
+    USLOSS_Console("Waiter(): MboxReceiveSub returned %d\n", result);
+    quit(4);
+    return 0;
+} /* Waiter */
+
+int Releaser(char *arg)
+{
+    USLOSS_Console("Releaser(): releasing the broadcast mailbox\n");
+    MboxRelease(releaseBox);
+    quit(5);
+    return 0;
+} /* Releaser */
+
+int CrowdPublisher(char *arg)
+{
+    USLOSS_Console("CrowdPublisher%s(): publishing to the full mailbox\n",
+                   arg);
+    int result = MboxPublish(crowdBox, arg, 2);
+    USLOSS_Console("CrowdPublisher%s(): MboxPublish returned %d\n", arg,
+                   result);
+    quit(6);
+    return 0;
+} /* CrowdPublisher */
+
+int Leaver(char *arg)
+{
+    USLOSS_Console("Leaver(): unsubscribing the only subscriber\n");
+    MboxUnsubscribe(crowdSub);
+    quit(7);
+    return 0;
+} /* Leaver */
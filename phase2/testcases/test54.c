@@ -0,0 +1,151 @@
+/* Priority-ordered mailboxes. Bulk messages sent with MboxSend are
+ * received after an urgent one sent later with MboxSendPriority, and
+ * before a less urgent one. On a full 1-slot mailbox, Urgent blocks after
+ * Bulk, a process of the same priority, but its message is received
+ * before Bulk's. Then processes of priority 4 block to receive from and
+ * send to priority mailboxes before ones of priority 2; with our phase 1
+ * the priority 2 ones are served first, with the reference one (which
+ * does not give process priorities) they are served FIFO.
+ */
+
+#include <phase1.h>
+#include <phase2.h>
+#include <usloss.h>
+#include <stdio.h>
+#include <string.h>
+
+int BulkSender(char *);
+int UrgentSender(char *);
+int Drainer(char *);
+int Orderer(char *);
+int Receiver(char *);
+int Sender(char *);
+
+int fullBox;
+int recvBox;
+int sendBox;
+char got[2][20];   /* what the priority 2 and 4 Receivers got */
+
+int start2(char *arg)
+{
+    char buf[20];
+    int box, status;
+
+    USLOSS_Console("start2(): started\n");
+    box = MboxCreatePriority(10, sizeof(buf));
+    MboxSend(box, "bulk1", 6);
+    MboxSend(box, "bulk2", 6);
+    MboxSendPriority(box, "low", 4, NUMMSGPRIOS - 1);
+    MboxSend(box, "bulk3", 6);
+    MboxSendPriority(box, "urgent", 7, 0);
+    MboxSendPriority(box, "urgent2", 8, 0);
+    while (MboxCondReceive(box, buf, sizeof(buf)) >= 0) {
+        USLOSS_Console("start2(): got %s\n", buf);
+    }
+    USLOSS_Console("start2(): MboxSendPriority with priority %d returned "
+                   "%d\n", NUMMSGPRIOS, MboxSendPriority(box, "bad", 4,
+                   NUMMSGPRIOS));
+
+    fullBox = MboxCreatePriority(1, sizeof(buf));
+    MboxSend(fullBox, "filler", 7);
+    fork1("BulkSender", BulkSender, NULL, 2 * USLOSS_MIN_STACK, 2);
+    fork1("UrgentSender", UrgentSender, NULL, 2 * USLOSS_MIN_STACK, 2);
+    fork1("Drainer", Drainer, NULL, 2 * USLOSS_MIN_STACK, 4);
+    for (int i = 0; i < 3; i++) {
+        join(&status);
+    }
+
+    recvBox = MboxCreatePriority(1, sizeof(buf));
+    sendBox = MboxCreatePriority(1, sizeof(buf));
+    fork1("Orderer", Orderer, NULL, 2 * USLOSS_MIN_STACK, 5);
+    join(&status);
+    quit(0);
+    return 0; /* so gcc will not complain about its absence... */
+} /* start2 */
+
+int BulkSender(char *arg)
+{
+    USLOSS_Console("BulkSender(): sending to the full mailbox\n");
+    MboxSend(fullBox, "bulk", 5);
+    USLOSS_Console("BulkSender(): sent\n");
+    quit(1);
+    return 0;
+} /* BulkSender */
+
+int UrgentSender(char *arg)
+{
+    USLOSS_Console("UrgentSender(): sending to the full mailbox\n");
+    MboxSendPriority(fullBox, "urgent", 7, 0);
+    USLOSS_Console("UrgentSender(): sent\n");
+    quit(2);
+    return 0;
+} /* UrgentSender */
+
+int Drainer(char *arg)
+{
+    char buf[20];
+
+    for (int i = 0; i < 3; i++) {
+        MboxReceive(fullBox, buf, sizeof(buf));
+        USLOSS_Console("Drainer(): got %s\n", buf);
+    }
+    quit(3);
+    return 0;
+} /* Drainer */
+
+int Orderer(char *arg)
+{
+    char buf[20];
+    char *first;
+    int status;
+
+#ifdef OWN_PHASE1
+    first = "2";
+#else
+    first = "4";
+#endif
+    /* each blocks as soon as it is forked, the priority 4 one first */
+    fork1("Receiver", Receiver, "4", 2 * USLOSS_MIN_STACK, 4);
+    fork1("Receiver", Receiver, "2", 2 * USLOSS_MIN_STACK, 2);
+    MboxSend(recvBox, "first", 6);
+    MboxSend(recvBox, "second", 7);
+    if (strcmp(got[first[0] == '2' ? 0 : 1], "first") == 0) {
+        USLOSS_Console("Orderer(): blocked receivers served in order\n");
+    } else {
+        USLOSS_Console("Orderer(): the priority 2 Receiver got %s, the "
+                       "priority 4 one %s\n", got[0], got[1]);
+    }
+
+    MboxSend(sendBox, "filler", 7);
+    fork1("Sender", Sender, "4", 2 * USLOSS_MIN_STACK, 4);
+    fork1("Sender", Sender, "2", 2 * USLOSS_MIN_STACK, 2);
+    MboxReceive(sendBox, buf, sizeof(buf));
+    USLOSS_Console("Orderer(): got %s\n", buf);
+    MboxReceive(sendBox, buf, sizeof(buf));
+    if (strcmp(buf, first) == 0) {
+        USLOSS_Console("Orderer(): blocked senders served in order\n");
+    } else {
+        USLOSS_Console("Orderer(): got the priority %s Sender's message "
+                       "first\n", buf);
+    }
+    MboxReceive(sendBox, buf, sizeof(buf));
+    for (int i = 0; i < 4; i++) {
+        join(&status);
+    }
+    quit(4);
+    return 0;
+} /* Orderer */
+
+int Receiver(char *arg)
+{
+    MboxReceive(recvBox, got[arg[0] == '2' ? 0 : 1], sizeof(got[0]));
+    quit(5);
+    return 0;
+} /* Receiver */
+
+int Sender(char *arg)
+{
+    MboxSend(sendBox, arg, 2);
+    quit(6);
+    return 0;
+} /* Sender */
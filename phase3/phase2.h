@@ -48,4 +48,8 @@ typedef struct systemArgs
 // 
 extern void (*systemCallVec[])(systemArgs *args);
 
+// times the system call the current process is making; only our own
+// phase2 has it
+extern void syscallDone(void);
+
 #endif
@@ -560,6 +560,10 @@ void cpuTime(systemArgs *args) {
 
 /* Sets the mode from kernel mode to user mode */
 void setUserMode() {
+#ifdef OWN_PHASE2
+    // time the system call while USLOSS_Clock still works
+    syscallDone();
+#endif
     USLOSS_PsrSet(USLOSS_PsrGet() & 14);
 }
 
@@ -596,6 +596,118 @@ int Mbox_CondReceive(int mboxID, void *msgPtr, int msgSize)
 } /* end of Mbox_CondReceive */
 
 
+/*
+ *  Routine:  Mbox_SendMany
+ *
+ *  Description: This is the call entry point for sending a batch of
+ *               messages with one system call.
+ *
+ *  Arguments:    int mboxID       -- id of the mailbox to send to
+ *                void *msgPtrs[]  -- messages to send, in order
+ *                int msgSizes[]   -- size of each message
+ *                int count        -- number of messages
+ *
+ *  Return Value: number of messages sent, which is less than count if
+ *                the mailbox filled, -1 means error occurs
+ *
+ */
+int Mbox_SendMany(int mboxID, void *msgPtrs[], int msgSizes[], int count)
+{
+    systemArgs sysArg;
+
+    CHECKMODE;
+    sysArg.number = SYS_MBOXSENDMANY;
+    sysArg.arg1 = (void *) (long) mboxID;
+    sysArg.arg2 = (void *) msgPtrs;
+    sysArg.arg3 = (void *) msgSizes;
+    sysArg.arg4 = (void *) (long) count;
+    USLOSS_Syscall(&sysArg);
+    return ((int) (long) sysArg.arg4);
+} /* end of Mbox_SendMany */
+
+
+/*
+ *  Routine:  Mbox_ReceiveMany
+ *
+ *  Description: This is the call entry point for receiving a batch of
+ *               messages with one system call.
+ *
+ *  Arguments:    int mboxID       -- id of the mailbox to receive from
+ *                void *msgPtrs[]  -- buffers to receive into
+ *                int msgSizes[]   -- size of each buffer
+ *                                    (output value: size of each message)
+ *                int count        -- number of buffers
+ *
+ *  Return Value: number of messages received, at least 1 unless an
+ *                error occurs, -1 means error occurs
+ *
+ */
+int Mbox_ReceiveMany(int mboxID, void *msgPtrs[], int msgSizes[], int count)
+{
+    systemArgs sysArg;
+
+    CHECKMODE;
+    sysArg.number = SYS_MBOXRECEIVEMANY;
+    sysArg.arg1 = (void *) (long) mboxID;
+    sysArg.arg2 = (void *) msgPtrs;
+    sysArg.arg3 = (void *) msgSizes;
+    sysArg.arg4 = (void *) (long) count;
+    USLOSS_Syscall(&sysArg);
+    return ((int) (long) sysArg.arg4);
+} /* end of Mbox_ReceiveMany */
+
+
+/*
+ *  Routine:  SyscallStats
+ *
+ *  Description: This is the call entry point for reading the counters
+ *               the kernel keeps for a system call.
+ *
+ *  Arguments:    int number           -- system call number
+ *                syscallStats *stats  -- where to copy the counters
+ *
+ *  Return Value: 0 means success, -1 means error occurs
+ *
+ */
+int SyscallStats(int number, syscallStats *stats)
+{
+    systemArgs sysArg;
+
+    CHECKMODE;
+    sysArg.number = SYS_SYSCALLSTATS;
+    sysArg.arg1 = (void *) (long) number;
+    sysArg.arg2 = (void *) stats;
+    USLOSS_Syscall(&sysArg);
+    return ((int) (long) sysArg.arg4);
+} /* end of SyscallStats */
+
+
+/*
+ *  Routine:  RingEnter
+ *
+ *  Description: This is the call entry point for running a batch of
+ *               system calls from a submission ring with one trap.
+ *
+ *  Arguments:    sysRing *ring  -- ring with the submitted calls; their
+ *                                  completions are put in it
+ *                int count      -- most calls to run
+ *
+ *  Return Value: number of calls run, -1 means error occurs
+ *
+ */
+int RingEnter(sysRing *ring, int count)
+{
+    systemArgs sysArg;
+
+    CHECKMODE;
+    sysArg.number = SYS_RINGENTER;
+    sysArg.arg1 = (void *) ring;
+    sysArg.arg2 = (void *) (long) count;
+    USLOSS_Syscall(&sysArg);
+    return ((int) (long) sysArg.arg4);
+} /* end of RingEnter */
+
+
 /*
  *  Routine:  VmInit
  *
@@ -39,6 +39,12 @@ extern int  Mbox_Send       (int mboxID, void *msgPtr, int msgSize);
 extern int  Mbox_CondSend   (int mboxID, void *msgPtr, int msgSize);
 extern int  Mbox_Receive    (int mboxID, void *msgPtr, int msgSize);
 extern int  Mbox_CondReceive(int mboxID, void *msgPtr, int msgSize);
+extern int  Mbox_SendMany   (int mboxID, void *msgPtrs[], int msgSizes[],
+                             int count);
+extern int  Mbox_ReceiveMany(int mboxID, void *msgPtrs[], int msgSizes[],
+                             int count);
+extern int  SyscallStats    (int number, syscallStats *stats);
+extern int  RingEnter       (sysRing *ring, int count);
 
 // Phase 5 -- User Function Prototypes
 //extern void *VmInit(int mappings, int pages, int frames, int pagers);
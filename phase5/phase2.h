@@ -12,6 +12,18 @@
 #define MAXSLOTS        2500
 #define MAX_MESSAGE     150  // largest possible message in a single slot
 
+// system calls added by phase 2, past the USLOSS ones
+#define SYS_MBOXSENDMANY     31
+#define SYS_MBOXRECEIVEMANY  32
+#define SYS_SYSCALLSTATS     33
+#define SYS_RINGENTER        34
+
+// entries in each of the submission and completion rings, a power of two
+#define RING_ENTRIES         32
+
+// log2 latency buckets kept for each system call
+#define SYSSTAT_BUCKETS      24
+
 // returns id of mailbox, or -1 if no more mailboxes, -2 if invalid args
 extern int MboxCreate(int slots, int slot_size);
 
@@ -45,6 +57,41 @@ typedef struct systemArgs
         void *arg5;
 } systemArgs;
 
+// A batch of system calls for SYS_RINGENTER. The caller puts entries in
+// sq at sqTail and moves sqTail on; the kernel runs them in order from
+// sqHead, and puts each one, with its results, in cq at cqTail. The
+// caller reads completions from cqHead. Indexes only grow, and are taken
+// mod RING_ENTRIES.
+typedef struct ringEntry
+{
+        systemArgs args;
+        long userData;      // copied to the completion as is
+} ringEntry;
+
+typedef struct sysRing
+{
+        unsigned int sqHead;
+        unsigned int sqTail;
+        unsigned int cqHead;
+        unsigned int cqTail;
+        ringEntry sq[RING_ENTRIES];
+        ringEntry cq[RING_ENTRIES];
+} sysRing;
+
+// What syscallHandler has counted for one system call number. Times are
+// microseconds by USLOSS_Clock(), including any time spent blocked, for
+// the calls that have returned.
+typedef struct syscallStats
+{
+        int calls;
+        int returned;       // calls that have returned, and been timed
+        int errors;         // calls that left a negative result in arg4
+        long long totalTime;
+        int minTime;
+        int maxTime;
+        int buckets[SYSSTAT_BUCKETS]; // [0] is 0, [i] is 2^(i-1) to 2^i - 1
+} syscallStats;
+
 // 
 extern void (*systemCallVec[])(systemArgs *args);
 